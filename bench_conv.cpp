@@ -0,0 +1,141 @@
+#include "Conv2D.hpp"
+#include "Tensor.hpp"
+#include "Utils.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// Compara la convolucion de Conv2D (im2col + GEMM, o Winograd para 3x3 stride 1)
+// contra el bucle escalar original
+
+// Bucle escalar original de Conv2D::forward (referencia)
+Tensor reference_forward(const Conv2D &conv, const Tensor &input) {
+  size_t batch_size = input.shape[0], in_height = input.shape[2], in_width = input.shape[3];
+  size_t K = conv.kernel_size, S = conv.stride, P = conv.padding;
+  size_t out_height = (in_height + 2 * P - K) / S + 1;
+  size_t out_width = (in_width + 2 * P - K) / S + 1;
+  Tensor output({batch_size, conv.output_channels, out_height, out_width});
+
+  for (size_t b = 0; b < batch_size; ++b)
+    for (size_t oc = 0; oc < conv.output_channels; ++oc)
+      for (size_t oh = 0; oh < out_height; ++oh)
+        for (size_t ow = 0; ow < out_width; ++ow) {
+          float sum = conv.bias.data[oc];
+          for (size_t ic = 0; ic < conv.input_channels; ++ic)
+            for (size_t kh = 0; kh < K; ++kh)
+              for (size_t kw = 0; kw < K; ++kw) {
+                size_t ih = oh * S + kh - P;
+                size_t iw = ow * S + kw - P;
+                if (ih < in_height && iw < in_width)
+                  sum += input.data[((b * conv.input_channels + ic) * in_height + ih) * in_width + iw] *
+                         conv.kernels.data[((oc * conv.input_channels + ic) * K + kh) * K + kw];
+              }
+          output.data[((b * conv.output_channels + oc) * out_height + oh) * out_width + ow] = sum;
+        }
+  return output;
+}
+
+// Bucle escalar original de Conv2D::backward (referencia)
+Tensor reference_backward(const Conv2D &conv, const Tensor &input, const Tensor &grad_output, Tensor &grad_kernels,
+                          Tensor &grad_bias) {
+  Tensor grad_input(input.shape);
+  size_t batch_size = input.shape[0], in_height = input.shape[2], in_width = input.shape[3];
+  size_t out_height = grad_output.shape[2], out_width = grad_output.shape[3];
+  size_t K = conv.kernel_size, S = conv.stride, P = conv.padding;
+
+  for (size_t b = 0; b < batch_size; ++b)
+    for (size_t oc = 0; oc < conv.output_channels; ++oc)
+      for (size_t oh = 0; oh < out_height; ++oh)
+        for (size_t ow = 0; ow < out_width; ++ow) {
+          float grad = grad_output.data[((b * conv.output_channels + oc) * out_height + oh) * out_width + ow];
+          grad_bias.data[oc] += grad;
+          for (size_t ic = 0; ic < conv.input_channels; ++ic)
+            for (size_t kh = 0; kh < K; ++kh)
+              for (size_t kw = 0; kw < K; ++kw) {
+                size_t ih = oh * S + kh - P;
+                size_t iw = ow * S + kw - P;
+                if (ih < in_height && iw < in_width) {
+                  size_t input_idx = ((b * conv.input_channels + ic) * in_height + ih) * in_width + iw;
+                  size_t kernel_idx = ((oc * conv.input_channels + ic) * K + kh) * K + kw;
+                  grad_kernels.data[kernel_idx] += input.data[input_idx] * grad;
+                  grad_input.data[input_idx] += conv.kernels.data[kernel_idx] * grad;
+                }
+              }
+        }
+  return grad_input;
+}
+
+float max_abs_diff(const Tensor &a, const Tensor &b) {
+  float diff = 0.0f;
+  for (size_t i = 0; i < a.data.size(); ++i)
+    diff = max(diff, fabs(a.data[i] - b.data[i]));
+  return diff;
+}
+
+void bench(size_t in_ch, size_t out_ch, size_t kernel, size_t stride, size_t pad, size_t batch, size_t size, int reps) {
+  Conv2D conv(in_ch, out_ch, kernel, stride, pad);
+  std::default_random_engine rng(42);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+  Tensor input({batch, in_ch, size, size});
+  for (float &v : input.data)
+    v = dist(rng);
+
+  // Correctitud contra la referencia
+  Tensor out = conv.forward(input).clone();
+  Tensor ref_out = reference_forward(conv, input);
+  Tensor grad_output(out.shape);
+  for (float &v : grad_output.data)
+    v = dist(rng) - 0.5f;
+
+  conv.zero_grad();
+  Tensor grad_input = conv.backward(grad_output).clone();
+  Tensor ref_grad_kernels(conv.kernels.shape), ref_grad_bias(conv.bias.shape);
+  Tensor ref_grad_input = reference_backward(conv, input, grad_output, ref_grad_kernels, ref_grad_bias);
+  float diff_out = max_abs_diff(out, ref_out);
+  float diff_dx = max_abs_diff(grad_input, ref_grad_input);
+  float diff_dw = max_abs_diff(conv.grad_kernels, ref_grad_kernels);
+
+  // Tiempos
+  auto start = start_timer();
+  for (int r = 0; r < reps; ++r)
+    reference_forward(conv, input);
+  double ref_fwd = stop_timer(start) / reps;
+
+  start = start_timer();
+  for (int r = 0; r < reps; ++r)
+    conv.forward(input);
+  double fwd = stop_timer(start) / reps;
+
+  start = start_timer();
+  for (int r = 0; r < reps; ++r)
+    reference_backward(conv, input, grad_output, ref_grad_kernels, ref_grad_bias);
+  double ref_bwd = stop_timer(start) / reps;
+
+  start = start_timer();
+  for (int r = 0; r < reps; ++r)
+    conv.backward(grad_output);
+  double bwd = stop_timer(start) / reps;
+
+  cout << "conv2d(" << in_ch << ", " << out_ch << ", " << kernel << ", " << stride << ", " << pad << ") batch=" << batch
+       << " " << size << "x" << size << endl;
+  const string path = conv.use_winograd() ? "winograd   " : "im2col+gemm";
+  cout << fixed << setprecision(3);
+  cout << "  forward : bucle " << ref_fwd * 1e3 << " ms | " << path << " " << fwd * 1e3 << " ms | x" << ref_fwd / fwd
+       << "  (max diff " << scientific << diff_out << ")" << fixed << endl;
+  cout << "  backward: bucle " << ref_bwd * 1e3 << " ms | im2col+gemm " << bwd * 1e3 << " ms | x" << ref_bwd / bwd
+       << "  (max diff dX " << scientific << diff_dx << ", dW " << diff_dw << ")" << fixed << endl;
+}
+
+int main() {
+  cout << "kernels SIMD: " << simd::kernels().name << endl;
+  // Capa de cnn.cpp sobre un batch de MNIST
+  bench(1, 8, 5, 2, 2, 64, 28, 20);
+  // Capa 3x3 por defecto con mas canales (Winograd en forward)
+  bench(8, 16, 3, 1, 1, 16, 14, 10);
+  bench(32, 64, 3, 1, 1, 16, 14, 5);
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include "Conv2D.hpp"
+#include "Dataset.hpp"
+#include "Flatten.hpp"
+#include "NeuralNetwork.hpp"
+#include "Pool2D.hpp"
+#include "Tensor.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Rendimiento de inferencia del modelo de cnn.cpp sobre el conjunto de test de MNIST:
+// imagenes por segundo y latencia por peticion (p50 / p99) para varios tamaños de batch
+
+const string TEST_PATH = "./database/mnist_test.bin";
+const string MODEL_PATH = "models/cnn_mnist.bin";
+
+double percentile(vector<double> values, double p) {
+  sort(values.begin(), values.end());
+  size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+  return values[index];
+}
+
+void bench(NeuralNetwork &model, const Tensor &images, size_t batch) {
+  const size_t total = images.shape[0];
+  const ConstTensorView all = images;
+
+  // Peticiones armadas antes de medir (cada una con su propio tensor)
+  vector<Tensor> requests;
+  for (size_t start = 0; start + batch <= total; start += batch) {
+    requests.push_back(all.slice(start, start + batch).clone());
+  }
+
+  model.predict(requests.front()); // Calentamiento (arena y caches)
+
+  vector<double> latencies;
+  latencies.reserve(requests.size());
+  auto start = start_timer();
+  for (const Tensor &request : requests) {
+    auto t0 = start_timer();
+    model.predict(request);
+    latencies.push_back(stop_timer(t0));
+  }
+  double elapsed = stop_timer(start);
+
+  cout << setw(7) << batch << " | " << setw(12) << fixed << setprecision(0) << requests.size() * batch / elapsed << " | "
+       << setw(9) << setprecision(3) << percentile(latencies, 0.50) * 1e3 << " | " << setw(9)
+       << percentile(latencies, 0.99) * 1e3 << endl;
+}
+
+int main() {
+  cout << "kernels SIMD: " << simd::kernels().name << endl;
+
+  // El formato versionado se proyecta con mmap (capas y pesos salen del archivo);
+  // el anterior necesita la arquitectura armada y copia los pesos
+  NeuralNetwork model;
+  auto load_start = start_timer();
+  if (filesystem::exists(MODEL_PATH) && model_file::is_model_file(MODEL_PATH)) {
+    model.map_model(MODEL_PATH);
+    cout << "Pesos: " << MODEL_PATH << " (mmap, " << fixed << setprecision(3) << stop_timer(load_start) * 1e3
+         << " ms)" << endl;
+  } else {
+    model.add_layer(conv2d(1, 8, 5, 2, 2));
+    model.add_layer(pool(2, 2, PoolingType::MAX));
+    model.add_layer(flatten());
+    model.add_layer(dense(392, 32, "relu"));
+    model.add_layer(dense(32, 10, "softmax"));
+    if (filesystem::exists(MODEL_PATH)) {
+      model.load_model(MODEL_PATH);
+      cout << "Pesos: " << MODEL_PATH << " (" << fixed << setprecision(3) << stop_timer(load_start) * 1e3 << " ms)"
+           << endl;
+    } else {
+      cout << "Pesos: aleatorios (no existe " << MODEL_PATH << ")" << endl;
+    }
+  }
+
+  MnistDataset test(TEST_PATH, SampleLayout::IMAGE);
+  Tensor images, labels;
+  test.get_batch(0, test.size(), images, labels);
+
+  // Todo el conjunto en una llamada (predict lo procesa por tramos)
+  auto start = start_timer();
+  Tensor pred = model.predict(images);
+  double elapsed = stop_timer(start);
+  cout << "Test completo: " << test.size() << " imagenes en " << fixed << setprecision(3) << elapsed * 1e3 << " ms ("
+       << setprecision(0) << test.size() / elapsed << " img/s), precision " << setprecision(2)
+       << 100.0f * model.accuracy(pred, labels) / test.size() << "%" << endl;
+
+  cout << "\n  batch |        img/s |  p50 (ms) |  p99 (ms)" << endl;
+  for (size_t batch : {1, 8, 32, 128, 512}) {
+    if (batch <= test.size()) {
+      bench(model, images, batch);
+    }
+  }
+  return 0;
+}
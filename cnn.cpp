@@ -1,9 +1,9 @@
 #include "Conv2D.hpp"
+#include "Dataset.hpp"
 #include "Dropout.hpp"
 #include "Flatten.hpp"
 #include "Layer.hpp"
 #include "NeuralNetwork.hpp"
-#include "Reader.hpp"
 #include "Tensor.hpp"
 #include "Utils.hpp"
 
@@ -16,7 +16,7 @@ const string LOSS_FUNCTION = "cross-entropy";
 const string OPTIMIZER = "sgd";
 const int BATCH_SIZE = 10;
 
-void test_model(NeuralNetwork &model, vector<Tensor> &X_test, vector<Tensor> &Y_test);
+void test_model(NeuralNetwork &model, const Dataset &test);
 
 int main() {
   NeuralNetwork model;
@@ -28,28 +28,23 @@ int main() {
   model.add_layer(dense(392, 32, "relu"));
   model.add_layer(dense(32, 10, "softmax"));
 
-  model.compile(LOSS_FUNCTION, OPTIMIZER, LEARNING_RATE);
+  // Valida las formas capa por capa y planifica la memoria para batches [BATCH_SIZE, 1, 28, 28]
+  model.compile(Shape{BATCH_SIZE, 1, 28, 28}, LOSS_FUNCTION, OPTIMIZER, LEARNING_RATE);
   cout << "Modelo CNN compilado exitosamente." << endl;
+  const MemoryPlan &plan = model.memory_plan();
+  cout << "Memoria de trabajo: " << plan.size * sizeof(float) / 1024 << " KB (sin compartir: "
+       << plan.unshared * sizeof(float) / 1024 << " KB)" << endl;
 
-  // Cargar datos (asegurarse que Reader::load_bin carga MNIST correctamente)
-  vector<vector<float>> raw_X_train, raw_Y_train;
-  Reader::load_bin("./database/mnist_train.bin", raw_X_train, raw_Y_train, 60000);
+  // Cargar datos (mmap: los batches [N, 1, 28, 28] se convierten a float al armarse)
+  MnistDataset train("./database/mnist_train.bin", SampleLayout::IMAGE, 60000);
 
   // Validación y test
-  vector<vector<float>> raw_X_test, raw_Y_test;
-  Reader::load_bin("./database/mnist_test.bin", raw_X_test, raw_Y_test, 10000);
-  cout << raw_X_train[0].size() << endl; // 784
-  cout << raw_Y_train[0].size() << endl; // 10 one hot
-
-  // Convertir a tensores
-  vector<Tensor> X_train = to_tensor_batch_4D(raw_X_train);
-  vector<Tensor> Y_train = to_tensor_batch_1D(raw_Y_train);
-  vector<Tensor> X_test = to_tensor_batch_4D(raw_X_test);
-  vector<Tensor> Y_test = to_tensor_batch_1D(raw_Y_test);
+  MnistDataset test("./database/mnist_test.bin", SampleLayout::IMAGE, 10000);
+  cout << "Datos de entrenamiento: " << train.size() << ", test: " << test.size() << endl;
 
   // Entrenamiento
   auto start = start_timer();
-  model.fit(X_train, Y_train, X_test, Y_test, EPOCHS, BATCH_SIZE, 1, true);
+  model.fit(train, test, EPOCHS, BATCH_SIZE, 1, true);
   double duration = stop_timer(start);
   print_duration(duration, "Tiempo de entrenamiento");
 
@@ -57,23 +52,20 @@ int main() {
   cout << "\nGuardando el modelo entrenado..." << endl;
   model.save_model("cnn_mnist.bin");
 
-  test_model(model, X_test, Y_test);
+  test_model(model, test);
 
   return 0;
 }
 
-void test_model(NeuralNetwork &model, vector<Tensor> &X_test, vector<Tensor> &Y_test) {
+void test_model(NeuralNetwork &model, const Dataset &test) {
+  const size_t batch = 100;
+  Tensor X_batch, Y_batch;
   int correct = 0;
-  int total = X_test.size();
-
-  for (int i = 0; i < total; i++) {
-    Tensor pred = model.predict(X_test[i]);
-    int pred_label = argmax(pred);
-    int true_label = argmax(Y_test[i]);
+  int total = test.size();
 
-    if (pred_label == true_label) {
-      correct++;
-    }
+  for (size_t start = 0; start < test.size(); start += batch) {
+    test.get_batch(start, min(start + batch, test.size()), X_batch, Y_batch);
+    correct += static_cast<int>(model.accuracy(model.predict(X_batch), Y_batch));
   }
 
   float accuracy = 100.0f * correct / total;
@@ -0,0 +1,71 @@
+#include "Conv2D.hpp"
+#include "Dataset.hpp"
+#include "Distributed.hpp"
+#include "Flatten.hpp"
+#include "NeuralNetwork.hpp"
+#include "Pool2D.hpp"
+#include "Utils.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+// Entrenamiento distribuido del modelo de cnn.cpp en varios procesos de esta maquina:
+//   ./cnn_distributed <rank> <procesos> [puerto_base]
+// Cada proceso entrena con su parte del conjunto de entrenamiento y los gradientes se
+// promedian en cada paso (all-reduce en anillo por TCP). Al terminar todos los procesos
+// tienen los mismos pesos: cada uno imprime una suma de control para comprobarlo.
+
+const int EPOCHS = 2;
+const float LEARNING_RATE = 0.001f;
+const int BATCH_SIZE = 10; // Por proceso: el batch efectivo es BATCH_SIZE * procesos
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    cerr << "Uso: " << argv[0] << " <rank> <procesos> [puerto_base]" << endl;
+    return 1;
+  }
+  const size_t rank = strtoul(argv[1], nullptr, 10);
+  const size_t world = strtoul(argv[2], nullptr, 10);
+  const int base_port = argc > 3 ? atoi(argv[3]) : 29500;
+
+  NeuralNetwork model;
+  model.add_layer(conv2d(1, 8, 5, 2, 2));
+  model.add_layer(pool(2, 2, PoolingType::MAX));
+  model.add_layer(flatten());
+  model.add_layer(dense(392, 32, "relu"));
+  model.add_layer(dense(32, 10, "softmax"));
+  model.compile(Shape{BATCH_SIZE, 1, 28, 28}, "cross-entropy", "adam", LEARNING_RATE);
+
+  RingCommunicator ring(rank, RingCommunicator::localhost(world, base_port));
+  model.set_distributed(ring);
+
+  MnistDataset train("./database/mnist_train.bin", SampleLayout::IMAGE, 60000);
+  MnistDataset test("./database/mnist_test.bin", SampleLayout::IMAGE, 10000);
+  DatasetShard shard(train, rank, world);
+  if (rank == 0) {
+    cout << "Procesos: " << world << ", muestras por proceso: " << shard.size() << endl;
+  }
+
+  auto start = start_timer();
+  model.fit(shard, test, EPOCHS, BATCH_SIZE, rank == 0 ? 1 : 0);
+  double duration = stop_timer(start);
+
+  // Suma de control de las predicciones sobre el test (igual en todos los procesos)
+  Tensor X_test, Y_test;
+  test.get_batch(0, test.size(), X_test, Y_test);
+  Tensor pred = model.predict(X_test);
+  double checksum = 0.0;
+  for (size_t i = 0; i < pred.data.size(); ++i) {
+    checksum += pred.data[i] * static_cast<double>(i % 7 + 1);
+  }
+  cout << "[rank " << rank << "] suma de control " << setprecision(17) << checksum << ", precision " << fixed
+       << setprecision(2) << 100.0f * model.accuracy(pred, Y_test) / test.size() << "%" << endl;
+
+  if (rank == 0) {
+    print_duration(duration, "Tiempo de entrenamiento");
+    model.save_model("cnn_mnist_distributed.bin");
+  }
+  return 0;
+}
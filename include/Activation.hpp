@@ -0,0 +1,100 @@
+#pragma once
+#include "Layer.hpp"
+#include "Math.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+// Capa de activacion sobre todo el buffer (kernels SIMD de apply_activation): ReLU, Sigmoid,
+// Tanh y Softmax. Equivale a la activacion de Dense o Conv2D y, en inferencia, se fusiona
+// con la capa anterior (Fusion.hpp)
+class ActivationLayer : public Layer {
+public:
+    Activation activation;
+
+    explicit ActivationLayer(Activation activation_) : activation(activation_) {
+        if (activation == Activation::LINEAR) {
+            throw std::invalid_argument("ActivationLayer: la activacion lineal no es una capa");
+        }
+    }
+
+    // Nombre de la capa en los archivos de modelo
+    static const char* layer_name(Activation activation) {
+        switch (activation) {
+            case Activation::RELU: return "ReLU";
+            case Activation::SIGMOID: return "Sigmoid";
+            case Activation::TANH: return "Tanh";
+            case Activation::SOFTMAX: return "Softmax";
+            default: return "Linear";
+        }
+    }
+
+    Shape output_shape(const Shape& input_shape) const override { return input_shape; }
+
+    void buffer_requests(const Shape& input_shape, vector<BufferRequest>& requests) const override {
+        requests.push_back({OUTPUT, input_shape.numel(), BufferUse::OUTPUT});
+        requests.push_back({GRAD_INPUT, input_shape.numel(), BufferUse::GRAD_INPUT});
+    }
+
+    // Forward pass: guarda la entrada (vista, sin copia) para el backward
+    ConstTensorView forward(ConstTensorView input) override {
+        last_input = input;
+        return infer(input, forward_workspace());
+    }
+
+    // Softmax por fila ([N, clases] o un vector); el resto elemento a elemento
+    ConstTensorView infer(ConstTensorView input, Workspace& ws) const override {
+        require_contiguous(input, layer_name(activation));
+        TensorView output = ws.tensor(this, OUTPUT, input.shape);
+        const size_t rows = (input.shape.size() > 1) ? input.shape[0] : 1;
+        apply_activation(activation, input.data, output.data, rows, input.get_size() / rows);
+        return output;
+    }
+
+    // dX = dY * f'(X). Softmax, como en Dense, solo se usa al final con cross-entropy, que
+    // ya entrega el gradiente respecto a la entrada del softmax
+    ConstTensorView backward(ConstTensorView grad_output) override {
+        require_contiguous(grad_output, layer_name(activation));
+        TensorView grad_input = backward_workspace().tensor(this, GRAD_INPUT, last_input.shape);
+        std::copy(grad_output.data, grad_output.data + grad_input.get_size(), grad_input.data);
+        apply_activation_grad(activation, last_input.data, grad_input.data, grad_input.get_size());
+        return grad_input;
+    }
+
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<ActivationLayer>(*this); }
+
+    void save(std::ostream& out) const override { out << layer_name(activation) << "\n"; }
+
+    // No hay gradientes que reiniciar
+    void zero_grad() override {}
+
+private:
+    enum Buffer { OUTPUT, GRAD_INPUT }; // Buffers en la arena
+
+    ConstTensorView last_input; // Entrada del ultimo forward
+};
+
+// Una clase por activacion (model.add_layer(make_unique<ReLU>()))
+template <Activation kind>
+class ActivationOf : public ActivationLayer {
+public:
+    ActivationOf() : ActivationLayer(kind) {}
+
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<ActivationOf>(*this); }
+};
+
+using ReLU = ActivationOf<Activation::RELU>;
+using Sigmoid = ActivationOf<Activation::SIGMOID>;
+using Tanh = ActivationOf<Activation::TANH>;
+using Softmax = ActivationOf<Activation::SOFTMAX>;
+
+inline std::unique_ptr<ActivationLayer> make_activation_layer(Activation activation) {
+    switch (activation) {
+        case Activation::RELU: return std::make_unique<ReLU>();
+        case Activation::SIGMOID: return std::make_unique<Sigmoid>();
+        case Activation::TANH: return std::make_unique<Tanh>();
+        case Activation::SOFTMAX: return std::make_unique<Softmax>();
+        default: return std::make_unique<ActivationLayer>(activation); // Lanza la excepcion
+    }
+}
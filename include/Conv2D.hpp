@@ -1,10 +1,13 @@
 #pragma once
 #include "Tensor.hpp"
 #include "Layer.hpp"
+#include "Math.hpp"
+#include "Threads.hpp"
 #include <vector>
 #include <cmath>
 #include <algorithm>
 #include <random>
+#include <sstream>
 
 
 // Capa de convolución 2D para redes neuronales
@@ -15,22 +18,38 @@ public:
     size_t kernel_size;     // Tamaño del kernel (cuadrado)
     size_t stride;         // Paso de la convolución
     size_t padding;        // Relleno en los bordes
+    Activation activation; // Activacion tras el bias (lineal, relu, sigmoid o tanh)
     
-    Tensor kernels;        // Filtros/kernels [output_channels, input_channels, kernel_size, kernel_size]
+    Tensor kernels;        // Filtros/kernels [output_channels, input_channels, kernel_size, kernel_size], fp32 o 16 bits
     Tensor bias;           // Sesgos [output_channels]
     
     // Cache para backpropagation
-    Tensor last_input;     // Última entrada [batch, in_channels, height, width]
+    ConstTensorView last_input; // Última entrada [batch, in_channels, height, width] (vista, sin copia)
+    TensorView last_output;     // Salida pre-activacion (solo con activacion)
     Tensor grad_kernels;   // Gradiente de los kernels
     Tensor grad_bias;      // Gradiente de los sesgos
 
-    // Constructor
+    // Cache de Winograd F(2x2, 3x3): filtros transformados U = G g G^T [16, out_channels, in_channels]
+    // en el tipo de los kernels. Se recalcula al crear la capa, tras cada paso del optimizador y al cargar pesos.
+    // Con kernels de 16 bits 'data' se conserva como buffer fp32 de la transformada (sin reservas por paso)
+    Tensor winograd_kernels;
+
+    // Constructor. Con 'allocate' = false los tensores solo tienen la forma (para map_parameters)
     Conv2D(size_t in_channels, size_t out_channels, 
           size_t kernel_size = 3, size_t stride = 1, 
-          size_t padding = 0)
+          size_t padding = 0, Activation activation_ = Activation::LINEAR, bool allocate = true)
         : input_channels(in_channels), output_channels(out_channels),
-          kernel_size(kernel_size), stride(stride), padding(padding) {
+          kernel_size(kernel_size), stride(stride), padding(padding), activation(activation_) {
+        if (activation == Activation::SOFTMAX) {
+            throw std::invalid_argument("Conv2D: softmax no es una activacion por elemento");
+        }
         
+        if (!allocate) {
+            kernels = grad_kernels = Tensor::unallocated({out_channels, in_channels, kernel_size, kernel_size});
+            bias = grad_bias = Tensor::unallocated({out_channels});
+            return;
+        }
+
         // Inicializar kernels y bias
         kernels = Tensor({out_channels, in_channels, kernel_size, kernel_size});
         bias = Tensor({out_channels});
@@ -38,8 +57,14 @@ public:
         grad_bias = Tensor(bias.shape);
         
         initialize_parameters();
+        refresh_winograd_cache();
     }
 
+    // Activacion por nombre ("relu", "sigmoid", "tanh"; "" o "linear": identidad)
+    Conv2D(size_t in_channels, size_t out_channels, size_t kernel_size, size_t stride, size_t padding,
+           const string& activation_, bool allocate = true)
+        : Conv2D(in_channels, out_channels, kernel_size, stride, padding, parse_activation(activation_), allocate) {}
+
     // Inicialización de parámetros (He initialization)
     void initialize_parameters() {
         float stddev = sqrt(2.0f / (input_channels * kernel_size * kernel_size));
@@ -55,73 +80,128 @@ public:
         }
     }
 
-    // Forward pass
-    Tensor forward(const Tensor& input) override {
+    // Kernels 3x3 con stride 1 usan Winograd F(2x2, 3x3); el resto im2col + GEMM
+    bool use_winograd() const {
+        return kernel_size == 3 && stride == 1;
+    }
+
+    // Recalcula los filtros transformados; llamar siempre que cambien los kernels.
+    // Se hace en el momento (no al usarla) para que infer() no modifique la capa
+    void refresh_winograd_cache() {
+        if (use_winograd()) {
+            update_winograd_kernels();
+        }
+    }
+
+    // [batch, in_channels, H, W] -> [batch, out_channels, H', W']
+    Shape output_shape(const Shape& input_shape) const override {
+        if (input_shape.size() != 4 || input_shape[1] != input_channels) {
+            std::ostringstream msg;
+            msg << "Conv2D: se esperaba una entrada [batch, " << input_channels << ", height, width] y es " << input_shape;
+            throw std::invalid_argument(msg.str());
+        }
+        if (input_shape[2] + 2 * padding < kernel_size || input_shape[3] + 2 * padding < kernel_size) {
+            throw std::invalid_argument("Conv2D: la imagen es mas pequeña que el kernel");
+        }
+        return {input_shape[0], output_channels,
+                (input_shape[2] + 2 * padding - kernel_size) / stride + 1,
+                (input_shape[3] + 2 * padding - kernel_size) / stride + 1};
+    }
+
+    void buffer_requests(const Shape& input_shape, vector<BufferRequest>& requests) const override {
+        const Shape out = output_shape(input_shape);
+        const size_t threads = batch_threads(input_shape[0]);
+        const size_t patch = input_channels * kernel_size * kernel_size;
+        const size_t pixels = out[2] * out[3];
+
+        requests.push_back({OUTPUT, out.numel(), BufferUse::OUTPUT});
+        if (activation != Activation::LINEAR) {
+            requests.push_back({PRE_ACTIVATION, out.numel(), BufferUse::SAVED});
+            requests.push_back({GRAD_Z, out.numel(), BufferUse::BACKWARD_SCRATCH});
+        }
+        if (use_winograd()) {
+            const size_t tiles = ((out[2] + 1) / 2) * ((out[3] + 1) / 2);
+            requests.push_back({WINOGRAD_V, threads * 16 * input_channels * tiles, BufferUse::FORWARD_SCRATCH});
+            requests.push_back({WINOGRAD_M, threads * 16 * output_channels * tiles, BufferUse::FORWARD_SCRATCH});
+        } else {
+            requests.push_back({COLUMNS, threads * patch * pixels, BufferUse::FORWARD_SCRATCH});
+        }
+
+        if (threads > 1) { // Acumuladores por hilo
+            requests.push_back({LOCAL_KERNELS, threads * kernels.shape.numel(), BufferUse::BACKWARD_SCRATCH});
+            requests.push_back({LOCAL_BIAS, threads * output_channels, BufferUse::BACKWARD_SCRATCH});
+        }
+        requests.push_back({BACKWARD_COLUMNS, threads * patch * pixels, BufferUse::BACKWARD_SCRATCH});
+        requests.push_back({GRAD_COLUMNS, threads * patch * pixels, BufferUse::BACKWARD_SCRATCH});
+        requests.push_back({GRAD_INPUT, input_shape.numel(), BufferUse::GRAD_INPUT});
+    }
+
+    // Forward pass: guarda la entrada (y con activacion la pre-activacion) para el backward
+    ConstTensorView forward(ConstTensorView input) override {
+        Workspace& ws = forward_workspace();
         last_input = input;
-        
-        // Dimensiones de entrada [batch, in_channels, height, width]
-        size_t batch_size = input.shape[0];
-        size_t in_height = input.shape[2];
-        size_t in_width = input.shape[3];
-        
-        // Calcular dimensiones de salida
-        size_t out_height = (in_height + 2*padding - kernel_size) / stride + 1;
-        size_t out_width = (in_width + 2*padding - kernel_size) / stride + 1;
-        
-        Tensor output({batch_size, output_channels, out_height, out_width});
-        
-        // Aplicar convolución para cada elemento del batch
-        for (size_t b = 0; b < batch_size; ++b) {
-            for (size_t oc = 0; oc < output_channels; ++oc) {
-                for (size_t oh = 0; oh < out_height; ++oh) {
-                    for (size_t ow = 0; ow < out_width; ++ow) {
-                        
-                        float sum = bias.data[oc];
-                        
-                        // Aplicar kernel
-                        for (size_t ic = 0; ic < input_channels; ++ic) {
-                            for (size_t kh = 0; kh < kernel_size; ++kh) {
-                                for (size_t kw = 0; kw < kernel_size; ++kw) {
-                                    
-                                    size_t ih = oh*stride + kh - padding;
-                                    size_t iw = ow*stride + kw - padding;
-                                    
-                                    // Comprobar bordes
-                                    if (ih < in_height && iw < in_width) {
-                                        size_t input_idx = b * input.shape[1] * input.shape[2] * input.shape[3] +
-                                                         ic * input.shape[2] * input.shape[3] +
-                                                         ih * input.shape[3] + 
-                                                         iw;
-                                        
-                                        size_t kernel_idx = oc * kernels.shape[1] * kernels.shape[2] * kernels.shape[3] +
-                                                           ic * kernels.shape[2] * kernels.shape[3] +
-                                                           kh * kernels.shape[3] + 
-                                                           kw;
-                                        
-                                        sum += input.data[input_idx] * kernels.data[kernel_idx];
-                                    }
-                                }
-                            }
-                        }
-                        
-                        // Guardar resultado
-                        size_t output_idx = b * output.shape[1] * output.shape[2] * output.shape[3] +
-                                          oc * output.shape[2] * output.shape[3] +
-                                          oh * output.shape[3] + 
-                                          ow;
-                        
-                        output.data[output_idx] = sum;
-                    }
-                }
-            }
+        if (activation == Activation::LINEAR) {
+            return convolve(input, ws, OUTPUT, false);
         }
-        
-        return output;
+        last_output = convolve(input, ws, PRE_ACTIVATION, false);
+        TensorView activated = ws.tensor(this, OUTPUT, last_output.shape);
+        apply_activation(activation, last_output.data, activated.data, 1, last_output.get_size());
+        return activated;
     }
 
-    // Backward pass
-    Tensor backward(const Tensor& grad_output) override {
-        Tensor grad_input(last_input.shape);
+    // Inferencia sin estado: la activacion se aplica a cada muestra al terminar su convolucion
+    ConstTensorView infer(ConstTensorView input, Workspace& ws) const override {
+        return convolve(input, ws, OUTPUT, true);
+    }
+
+    // Camino fusionado (Fusion.hpp): filas de salida [row_begin, row_end) de una muestra
+    // [in_channels, height, width] con bias y la activacion 'act' (la de la capa o la de una
+    // capa de activacion que la sigue), en 'out' [out_channels, filas, out_width].
+    // Con Winograd 'row_begin' debe ser par. 'scratch' tiene rows_scratch(width, filas) floats
+    void infer_rows(const float* image, size_t height, size_t width, size_t row_begin, size_t row_end,
+                    float* out, float* scratch, Activation act) const {
+        const size_t out_height = (height + 2 * padding - kernel_size) / stride + 1;
+        const size_t out_width = (width + 2 * padding - kernel_size) / stride + 1;
+        const size_t pixels = (row_end - row_begin) * out_width;
+
+        if (use_winograd()) {
+            const size_t tiles = ((row_end - row_begin + 1) / 2) * ((out_width + 1) / 2);
+            winograd_rows(image, height, width, row_begin, row_end, scratch,
+                          scratch + 16 * input_channels * tiles, out);
+        } else {
+            const size_t patch = input_channels * kernel_size * kernel_size;
+            im2col(image, input_channels, height, width, kernel_size, stride, padding,
+                   out_height, out_width, scratch, row_begin, row_end);
+            parallel_gemm(parameter_view(0, kernels), scratch, out, output_channels, pixels, patch);
+            add_bias(out, pixels);
+        }
+        apply_activation(act, out, out, 1, output_channels * pixels);
+    }
+
+    // Floats de 'scratch' para infer_rows con 'rows' filas de salida
+    size_t rows_scratch(size_t width, size_t rows) const {
+        const size_t out_width = (width + 2 * padding - kernel_size) / stride + 1;
+        if (use_winograd()) {
+            return 16 * (input_channels + output_channels) * ((rows + 1) / 2) * ((out_width + 1) / 2);
+        }
+        return input_channels * kernel_size * kernel_size * rows * out_width;
+    }
+
+    // Backward pass: reconstruye las columnas de la entrada y resuelve con GEMM
+    //   dW += dY * columnas^T,   d(columnas) = W^T * dY  -> col2im -> dX
+    // (con activacion, dY es el gradiente respecto a la pre-activacion)
+    ConstTensorView backward(ConstTensorView grad_output) override {
+        require_contiguous(grad_output, "Conv2D");
+        require_master(kernels, "Conv2D");
+        Workspace& ws = backward_workspace();
+        TensorView grad_input = ws.tensor(this, GRAD_INPUT, last_input.shape);
+
+        if (activation != Activation::LINEAR) {
+            TensorView grad_z = ws.tensor(this, GRAD_Z, grad_output.shape);
+            std::copy(grad_output.data, grad_output.data + grad_z.get_size(), grad_z.data);
+            apply_activation_grad(activation, last_output.data, grad_z.data, grad_z.get_size());
+            grad_output = grad_z;
+        }
         
         // Dimensiones
         size_t batch_size = last_input.shape[0];
@@ -129,56 +209,77 @@ public:
         size_t in_width = last_input.shape[3];
         size_t out_height = grad_output.shape[2];
         size_t out_width = grad_output.shape[3];
+
+        const size_t patch = input_channels * kernel_size * kernel_size;
+        const size_t pixels = out_height * out_width;
+        const size_t image_size = input_channels * in_height * in_width;
+        const size_t kernel_count = kernels.get_size();
+
+        // En modo batch cada hilo acumula dW y db en su propio buffer y al final se
+        // reducen en orden fijo (sin carreras y con resultado determinista)
+        const int threads = batch_threads(batch_size);
+        float* local_kernels = nullptr;
+        float* local_bias = nullptr;
+        if (threads > 1) {
+            local_kernels = ws.allocate(this, LOCAL_KERNELS, threads * kernel_count);
+            local_bias = ws.allocate(this, LOCAL_BIAS, threads * output_channels);
+            std::fill(local_kernels, local_kernels + threads * kernel_count, 0.0f);
+            std::fill(local_bias, local_bias + threads * output_channels, 0.0f);
+        }
+        float* cols = ws.allocate(this, BACKWARD_COLUMNS, threads * patch * pixels);
+        float* grad_cols = ws.allocate(this, GRAD_COLUMNS, threads * patch * pixels);
         
-        // Inicializar gradientes a cero
-        grad_kernels.fill(0.0f);
-        grad_bias.fill(0.0f);
-        
-        // Calcular gradientes
-        for (size_t b = 0; b < batch_size; ++b) {
-            for (size_t oc = 0; oc < output_channels; ++oc) {
-                for (size_t oh = 0; oh < out_height; ++oh) {
-                    for (size_t ow = 0; ow < out_width; ++ow) {
-                        
-                        float grad = grad_output.data[
-                            b * grad_output.shape[1] * grad_output.shape[2] * grad_output.shape[3] +
-                            oc * grad_output.shape[2] * grad_output.shape[3] +
-                            oh * grad_output.shape[3] + 
-                            ow
-                        ];
-                        
-                        // Gradiente del bias
-                        grad_bias.data[oc] += grad;
-                        
-                        for (size_t ic = 0; ic < input_channels; ++ic) {
-                            for (size_t kh = 0; kh < kernel_size; ++kh) {
-                                for (size_t kw = 0; kw < kernel_size; ++kw) {
-                                    
-                                    size_t ih = oh*stride + kh - padding;
-                                    size_t iw = ow*stride + kw - padding;
-                                    
-                                    if (ih < in_height && iw < in_width) {
-                                        // Posiciones en tensores
-                                        size_t input_idx = b * last_input.shape[1] * last_input.shape[2] * last_input.shape[3] +
-                                                         ic * last_input.shape[2] * last_input.shape[3] +
-                                                         ih * last_input.shape[3] + 
-                                                         iw;
-                                        
-                                        size_t kernel_idx = oc * kernels.shape[1] * kernels.shape[2] * kernels.shape[3] +
-                                                          ic * kernels.shape[2] * kernels.shape[3] +
-                                                          kh * kernels.shape[3] + 
-                                                          kw;
-                                        
-                                        // Gradiente de los kernels
-                                        grad_kernels.data[kernel_idx] += last_input.data[input_idx] * grad;
-                                        
-                                        // Gradiente de la entrada (si es necesario)
-                                        grad_input.data[input_idx] += kernels.data[kernel_idx] * grad;
-                                    }
-                                }
-                            }
-                        }
+        #pragma omp parallel if(threads > 1) num_threads(threads)
+        {
+            const int tid = thread_index();
+            float* acc_kernels = threads > 1 ? local_kernels + tid * kernel_count : grad_kernels.data.data();
+            float* acc_bias = threads > 1 ? local_bias + tid * output_channels : grad_bias.data.data();
+            float* col = cols + tid * patch * pixels;
+            float* grad_col = grad_cols + tid * patch * pixels;
+
+            // Calcular gradientes (se acumulan sobre todo el batch; zero_grad los reinicia)
+            #pragma omp for schedule(static)
+            for (size_t b = 0; b < batch_size; ++b) {
+                const float* grad = grad_output.data + b * output_channels * pixels;
+
+                // Gradiente del bias
+                for (size_t oc = 0; oc < output_channels; ++oc) {
+                    const float* row = grad + oc * pixels;
+                    float sum = 0.0f;
+                    for (size_t p = 0; p < pixels; ++p) {
+                        sum += row[p];
                     }
+                    acc_bias[oc] += sum;
+                }
+
+                // Gradiente de los kernels: [out_ch, pixels] x [pixels, patch]
+                im2col(last_input.data + b * image_size, input_channels, in_height, in_width,
+                       kernel_size, stride, padding, out_height, out_width, col);
+                parallel_gemm(grad, col, acc_kernels, output_channels, patch, pixels, false, true, true);
+
+                // Gradiente de la entrada: [patch, out_ch] x [out_ch, pixels], luego col2im
+                // (cada muestra escribe solo en su propia imagen de grad_input)
+                parallel_gemm(kernels.data.data(), grad, grad_col, patch, pixels, output_channels, true, false);
+                float* image = grad_input.data + b * image_size;
+                std::fill(image, image + image_size, 0.0f); // col2im acumula
+                col2im(grad_col, input_channels, in_height, in_width,
+                       kernel_size, stride, padding, out_height, out_width, image);
+            }
+        }
+
+        // Reduccion de los acumuladores por hilo
+        if (threads > 1) {
+            #pragma omp parallel for
+            for (size_t i = 0; i < kernel_count; ++i) {
+                float sum = 0.0f;
+                for (int t = 0; t < threads; ++t) {
+                    sum += local_kernels[t * kernel_count + i];
+                }
+                grad_kernels.data[i] += sum;
+            }
+            for (size_t oc = 0; oc < output_channels; ++oc) {
+                for (int t = 0; t < threads; ++t) {
+                    grad_bias.data[oc] += local_bias[t * output_channels + oc];
                 }
             }
         }
@@ -186,10 +287,33 @@ public:
         return grad_input;
     }
 
-    // Actualización de parámetros
-    void update_parameters(Optimizer& optimizer) override {
-        optimizer.update(kernels.data, grad_kernels.data);
-        optimizer.update(bias.data, grad_bias.data);
+    // Parámetros entrenables
+    void collect_parameters(vector<Parameter>& params) override {
+        params.push_back({&kernels, &grad_kernels});
+        params.push_back({&bias, &grad_bias});
+    }
+
+    // Los filtros cambiaron: la transformada de Winograd queda obsoleta
+    void parameters_updated() override {
+        refresh_winograd_cache();
+    }
+
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<Conv2D>(*this); }
+
+    // Guardar configuracion de la capa (la activacion y el tipo de los kernels solo si
+    // no son lineal / fp32)
+    void save(std::ostream& out) const override {
+        out << "Conv2D " << input_channels << " " << output_channels << " " << kernel_size << " " << stride << " "
+            << padding;
+        if (activation != Activation::LINEAR) out << " " << activation_name(activation);
+        if (kernels.dtype != DType::FLOAT32) out << " " << dtype_name(kernels.dtype);
+        out << "\n";
+    }
+
+    // Kernels (y su transformada de Winograd) en 16 bits; el bias queda en fp32
+    void set_precision(DType dtype, bool keep_master) override {
+        kernels.set_dtype(dtype, keep_master);
+        refresh_winograd_cache();
     }
 
     // Reiniciar gradientes
@@ -197,4 +321,265 @@ public:
         grad_kernels.fill(0.0f);
         grad_bias.fill(0.0f);
     }
+
+private:
+    // Buffers en la arena
+    enum Buffer { OUTPUT, COLUMNS, WINOGRAD_V, WINOGRAD_M, LOCAL_KERNELS, LOCAL_BIAS,
+                  BACKWARD_COLUMNS, GRAD_COLUMNS, GRAD_INPUT, PRE_ACTIVATION, GRAD_Z };
+
+    // Convolucion sin estado en el buffer 'slot': im2col + GEMM por cada elemento del batch
+    //   salida[oc, p] = kernels[oc, patch] * columnas[patch, p] + bias[oc]
+    // Con 'activate' la activacion se aplica a cada muestra apenas se calcula (en cache)
+    TensorView convolve(ConstTensorView input, Workspace& ws, int slot, bool activate) const {
+        if (input.shape.size() != 4 || input.shape[1] != input_channels) {
+            throw std::invalid_argument("Conv2D: se esperaba una entrada [batch, in_channels, height, width]");
+        }
+        require_contiguous(input, "Conv2D");
+
+        if (use_winograd()) {
+            return forward_winograd(input, ws, slot, activate);
+        }
+
+        // Dimensiones de entrada [batch, in_channels, height, width]
+        size_t batch_size = input.shape[0];
+        size_t in_height = input.shape[2];
+        size_t in_width = input.shape[3];
+        
+        // Calcular dimensiones de salida
+        size_t out_height = (in_height + 2*padding - kernel_size) / stride + 1;
+        size_t out_width = (in_width + 2*padding - kernel_size) / stride + 1;
+        
+        TensorView output = ws.tensor(this, slot, {batch_size, output_channels, out_height, out_width});
+
+        const size_t patch = input_channels * kernel_size * kernel_size; // Filas de la matriz de columnas
+        const size_t pixels = out_height * out_width;                    // Columnas (posiciones de salida)
+        const size_t image_size = input_channels * in_height * in_width;
+
+        // Con batch suficiente cada hilo procesa muestras completas; si no, cada GEMM
+        // reparte los canales de salida entre hilos (parallel_gemm)
+        const int threads = batch_threads(batch_size);
+        float* cols = ws.allocate(this, COLUMNS, threads * patch * pixels);
+        const WeightsView weights = parameter_view(0, kernels);
+        
+        #pragma omp parallel if(threads > 1) num_threads(threads)
+        {
+            float* col = cols + thread_index() * patch * pixels; // Matriz de columnas propia de cada hilo
+
+            // Aplicar convolución para cada elemento del batch
+            #pragma omp for schedule(static)
+            for (size_t b = 0; b < batch_size; ++b) {
+                im2col(input.data + b * image_size, input_channels, in_height, in_width,
+                       kernel_size, stride, padding, out_height, out_width, col);
+
+                float* out = output.data + b * output_channels * pixels;
+                parallel_gemm(weights, col, out, output_channels, pixels, patch);
+
+                add_bias(out, pixels);
+                if (activate) {
+                    apply_activation(activation, out, out, 1, output_channels * pixels);
+                }
+            }
+        }
+        
+        return output;
+    }
+
+    // Suma el bias de cada canal a 'out' [out_channels, pixels]
+    void add_bias(float* out, size_t pixels) const {
+        const float* bias_data = parameter_data(1, bias);
+        for (size_t oc = 0; oc < output_channels; ++oc) {
+            float* row = out + oc * pixels;
+            for (size_t p = 0; p < pixels; ++p) {
+                row[p] += bias_data[oc];
+            }
+        }
+    }
+
+    // Transforma los filtros 3x3: U = G g G^T con G = [[1,0,0], [.5,.5,.5], [.5,-.5,.5], [0,0,1]]
+    void update_winograd_kernels() {
+        const size_t channels = output_channels * input_channels;
+        const Shape shape{16, output_channels, input_channels};
+        if (!(winograd_kernels.shape == shape)) {
+            winograd_kernels = Tensor(shape);
+        }
+        winograd_kernels.data.resize(shape.numel()); // La transformada siempre se calcula en fp32
+        const WeightsView filters = parameter_view(0, kernels);
+
+        for (size_t k = 0; k < channels; ++k) {
+            float g[9];
+            for (size_t i = 0; i < 9; ++i) {
+                g[i] = filters[k * 9 + i];
+            }
+
+            // tmp = G g  [4 x 3]
+            float tmp[4][3];
+            for (size_t c = 0; c < 3; ++c) {
+                tmp[0][c] = g[c];
+                tmp[1][c] = 0.5f * (g[c] + g[3 + c] + g[6 + c]);
+                tmp[2][c] = 0.5f * (g[c] - g[3 + c] + g[6 + c]);
+                tmp[3][c] = g[6 + c];
+            }
+
+            // U = tmp G^T  [4 x 4], guardado como [xi*4 + nu][oc][ic]
+            for (size_t r = 0; r < 4; ++r) {
+                float u[4] = {
+                    tmp[r][0],
+                    0.5f * (tmp[r][0] + tmp[r][1] + tmp[r][2]),
+                    0.5f * (tmp[r][0] - tmp[r][1] + tmp[r][2]),
+                    tmp[r][2]
+                };
+                for (size_t c = 0; c < 4; ++c) {
+                    winograd_kernels.data[(r * 4 + c) * channels + k] = u[c];
+                }
+            }
+        }
+        // En 16 bits se redondea sobre 'half' ya reservado y se conserva el buffer fp32
+        winograd_kernels.set_dtype(kernels.dtype, true);
+    }
+
+    // Forward con Winograd F(2x2, 3x3): cada tile de salida 2x2 usa un tile de entrada 4x4.
+    // Las 16 posiciones del dominio transformado se resuelven como 16 GEMM
+    //   M[pos] = U[pos][out_ch, in_ch] * V[pos][in_ch, tiles]
+    // que requieren 16 multiplicaciones por tile frente a 36 de la convolucion directa.
+    TensorView forward_winograd(ConstTensorView input, Workspace& ws, int slot, bool activate) const {
+        size_t batch_size = input.shape[0];
+        size_t in_height = input.shape[2];
+        size_t in_width = input.shape[3];
+        size_t out_height = in_height + 2*padding - 2;
+        size_t out_width = in_width + 2*padding - 2;
+        size_t tiles = ((out_height + 1) / 2) * ((out_width + 1) / 2);
+
+        TensorView output = ws.tensor(this, slot, {batch_size, output_channels, out_height, out_width});
+
+        // Paralelo sobre el batch (buffers V y M por hilo) o, con batch pequeño,
+        // sobre canales de entrada, posiciones transformadas y canales de salida
+        const int threads = batch_threads(batch_size);
+        const size_t v_size = 16 * input_channels * tiles;
+        const size_t m_size = 16 * output_channels * tiles;
+        float* V_all = ws.allocate(this, WINOGRAD_V, threads * v_size);
+        float* M_all = ws.allocate(this, WINOGRAD_M, threads * m_size);
+
+        #pragma omp parallel if(threads > 1) num_threads(threads)
+        {
+            float* V = V_all + thread_index() * v_size; // Tiles de entrada transformados
+            float* M = M_all + thread_index() * m_size; // Producto en el dominio transformado
+
+            #pragma omp for schedule(static)
+            for (size_t b = 0; b < batch_size; ++b) {
+                float* out = output.data + b * output_channels * out_height * out_width;
+                winograd_rows(input.data + b * input_channels * in_height * in_width, in_height, in_width,
+                              0, out_height, V, M, out);
+                if (activate) {
+                    apply_activation(activation, out, out, 1, output_channels * out_height * out_width);
+                }
+            }
+        }
+
+        return output;
+    }
+
+    // Filas de salida [row_begin, row_end) (row_begin par) de una muestra con bias, en
+    // 'out' [out_channels, filas, out_width]. V y M tienen 16 * canales * tiles de esas filas
+    void winograd_rows(const float* image, size_t in_height, size_t in_width, size_t row_begin, size_t row_end,
+                       float* V, float* M, float* out_rows) const {
+        size_t out_width = in_width + 2*padding - 2;
+        size_t rows = row_end - row_begin;
+        size_t tile_begin = row_begin / 2;
+        size_t tiles_h = (rows + 1) / 2;
+        size_t tiles_w = (out_width + 1) / 2;
+        size_t tiles = tiles_h * tiles_w;
+        const float* bias_data = parameter_data(1, bias);
+
+        // 1. Transformar los tiles de entrada: V = B^T d B
+        #pragma omp parallel for if(!in_parallel_region())
+        for (size_t ic = 0; ic < input_channels; ++ic) {
+            const float* plane = image + ic * in_height * in_width;
+            for (size_t th = 0; th < tiles_h; ++th) {
+                for (size_t tw = 0; tw < tiles_w; ++tw) {
+                    // Leer tile 4x4 (ceros fuera de la imagen)
+                    float d[4][4];
+                    long h0 = static_cast<long>((tile_begin + th) * 2) - static_cast<long>(padding);
+                    long w0 = static_cast<long>(tw * 2) - static_cast<long>(padding);
+                    bool interior = h0 >= 0 && w0 >= 0 &&
+                                    h0 + 4 <= static_cast<long>(in_height) && w0 + 4 <= static_cast<long>(in_width);
+                    for (long r = 0; r < 4; ++r) {
+                        long ih = h0 + r;
+                        for (long c = 0; c < 4; ++c) {
+                            long iw = w0 + c;
+                            bool inside = interior || (ih >= 0 && iw >= 0 && ih < static_cast<long>(in_height) &&
+                                                       iw < static_cast<long>(in_width));
+                            d[r][c] = inside ? plane[ih * in_width + iw] : 0.0f;
+                        }
+                    }
+
+                    // tmp = B^T d con B^T = [[1,0,-1,0], [0,1,1,0], [0,-1,1,0], [0,1,0,-1]]
+                    float tmp[4][4];
+                    for (size_t c = 0; c < 4; ++c) {
+                        tmp[0][c] = d[0][c] - d[2][c];
+                        tmp[1][c] = d[1][c] + d[2][c];
+                        tmp[2][c] = d[2][c] - d[1][c];
+                        tmp[3][c] = d[1][c] - d[3][c];
+                    }
+
+                    // V = tmp B
+                    size_t tile = th * tiles_w + tw;
+                    for (size_t r = 0; r < 4; ++r) {
+                        float v[4] = {
+                            tmp[r][0] - tmp[r][2],
+                            tmp[r][1] + tmp[r][2],
+                            tmp[r][2] - tmp[r][1],
+                            tmp[r][1] - tmp[r][3]
+                        };
+                        for (size_t c = 0; c < 4; ++c) {
+                            V[((r * 4 + c) * input_channels + ic) * tiles + tile] = v[c];
+                        }
+                    }
+                }
+            }
+        }
+
+        // 2. Producto elemento a elemento en el dominio transformado (16 GEMM)
+        #pragma omp parallel for if(!in_parallel_region())
+        for (size_t pos = 0; pos < 16; ++pos) {
+            gemm(winograd_kernels.storage().offset(pos * output_channels * input_channels),
+                 V + pos * input_channels * tiles,
+                 M + pos * output_channels * tiles,
+                 output_channels, tiles, input_channels);
+        }
+
+        // 3. Transformar de vuelta: Y = A^T m A con A^T = [[1,1,1,0], [0,1,-1,-1]]
+        #pragma omp parallel for if(!in_parallel_region())
+        for (size_t oc = 0; oc < output_channels; ++oc) {
+            float* out = out_rows + oc * rows * out_width;
+            for (size_t th = 0; th < tiles_h; ++th) {
+                for (size_t tw = 0; tw < tiles_w; ++tw) {
+                    size_t tile = th * tiles_w + tw;
+                    float m[4][4];
+                    for (size_t pos = 0; pos < 16; ++pos) {
+                        m[pos / 4][pos % 4] = M[(pos * output_channels + oc) * tiles + tile];
+                    }
+
+                    float tmp[2][4];
+                    for (size_t c = 0; c < 4; ++c) {
+                        tmp[0][c] = m[0][c] + m[1][c] + m[2][c];
+                        tmp[1][c] = m[1][c] - m[2][c] - m[3][c];
+                    }
+
+                    for (size_t r = 0; r < 2; ++r) {
+                        size_t oh = th * 2 + r; // Fila dentro de [row_begin, row_end)
+                        if (oh >= rows) break;
+                        float y[2] = {
+                            tmp[r][0] + tmp[r][1] + tmp[r][2],
+                            tmp[r][1] - tmp[r][2] - tmp[r][3]
+                        };
+                        for (size_t c = 0; c < 2; ++c) {
+                            size_t ow = tw * 2 + c;
+                            if (ow >= out_width) break;
+                            out[oh * out_width + ow] = y[c] + bias_data[oc];
+                        }
+                    }
+                }
+            }
+        }
+    }
 };
\ No newline at end of file
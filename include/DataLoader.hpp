@@ -0,0 +1,200 @@
+#pragma once
+
+#include "Dataset.hpp"
+#include "Tensor.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Cargador de batches en segundo plano con doble buffer:
+// - un hilo propio mezcla los indices al inicio de cada epoca (si 'shuffle'),
+//   arma el batch y aplica la aumentacion de datos
+// - mientras el hilo de entrenamiento usa un buffer, el otro ya se esta llenando,
+//   asi la preparacion de datos queda oculta detras del computo
+// Los dos pares de tensores se reservan una vez y se reutilizan (solo el ultimo
+// batch de la epoca puede cambiar de forma).
+//
+// Uso:
+//   loader.start_epoch();
+//   const Tensor *X, *Y;
+//   while (loader.next(X, Y)) { ... }   // X e Y son validos hasta el siguiente next()
+class DataLoader {
+public:
+    // Aumentacion aplicada en el hilo del cargador sobre el batch ya armado
+    using Augmentation = function<void(Tensor &X, Tensor &Y, mt19937 &rng)>;
+
+private:
+    struct Slot {
+        Tensor X, Y;
+        bool ready = false; // Lleno y pendiente de consumir
+    };
+
+    const Dataset &dataset;
+    const size_t batch_size;
+    const bool shuffle;
+    Augmentation augmentation;
+
+    vector<size_t> order; // Orden de las muestras en la epoca actual (solo lo usa el hilo)
+    mt19937 rng;          // Mezcla y aumentacion (solo lo usa el hilo)
+    Slot slots[2];
+
+    mutex mtx;
+    condition_variable cv;
+    size_t epoch = 0;          // Epoca pedida por el consumidor
+    bool epoch_pending = false;
+    bool reseed = false;       // La epoca pedida trae semilla propia
+    unsigned epoch_seed = 0;
+    bool stopping = false;
+    size_t consumed = 0;       // Batches entregados en la epoca actual
+    int held = -1;             // Slot que esta usando el consumidor
+    exception_ptr error;
+
+    thread worker;
+
+    void release_held() {
+        if (held >= 0) {
+            slots[held].ready = false;
+            held = -1;
+            cv.notify_all();
+        }
+    }
+
+    void run() {
+        for (;;) {
+            size_t my_epoch;
+            bool my_reseed;
+            unsigned my_seed;
+            {
+                unique_lock<mutex> lock(mtx);
+                cv.wait(lock, [&] { return stopping || epoch_pending; });
+                if (stopping) return;
+                epoch_pending = false;
+                my_epoch = epoch;
+                my_reseed = reseed;
+                my_seed = epoch_seed;
+            }
+
+            if (my_reseed) { // El orden y la aumentacion solo dependen de la semilla
+                rng.seed(my_seed);
+                std::iota(order.begin(), order.end(), 0);
+            }
+            if (shuffle) {
+                std::shuffle(order.begin(), order.end(), rng);
+            }
+
+            for (size_t b = 0; b < num_batches(); ++b) {
+                Slot &slot = slots[b % 2];
+                {
+                    unique_lock<mutex> lock(mtx);
+                    cv.wait(lock, [&] { return stopping || epoch != my_epoch || !slot.ready; });
+                    if (stopping || epoch != my_epoch) break;
+                }
+
+                try {
+                    const size_t start = b * batch_size;
+                    const size_t n = std::min(batch_size, dataset.size() - start);
+                    dataset.prepare_batch(n, slot.X, slot.Y);
+                    dataset.fill_batch(order.data() + start, n, slot.X, slot.Y);
+                    if (augmentation) {
+                        augmentation(slot.X, slot.Y, rng);
+                    }
+                } catch (...) {
+                    lock_guard<mutex> lock(mtx);
+                    error = current_exception();
+                    cv.notify_all();
+                    break;
+                }
+
+                {
+                    lock_guard<mutex> lock(mtx);
+                    if (epoch != my_epoch) break; // Epoca abandonada: no se publica
+                    slot.ready = true;
+                }
+                cv.notify_all();
+            }
+        }
+    }
+
+public:
+    DataLoader(const Dataset &dataset_, size_t batch_size_, bool shuffle_ = true, unsigned seed = 42,
+               Augmentation augmentation_ = nullptr)
+        : dataset(dataset_), batch_size(batch_size_), shuffle(shuffle_), augmentation(std::move(augmentation_)),
+          order(dataset_.size()), rng(seed) {
+        if (batch_size == 0) {
+            throw std::invalid_argument("DataLoader: batch_size debe ser mayor que cero");
+        }
+        std::iota(order.begin(), order.end(), 0);
+        worker = thread(&DataLoader::run, this);
+    }
+
+    ~DataLoader() {
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+
+    DataLoader(const DataLoader &) = delete;
+    DataLoader &operator=(const DataLoader &) = delete;
+
+    size_t num_batches() const { return (dataset.size() + batch_size - 1) / batch_size; }
+
+    // Comienza una epoca (descarta lo que quede de la anterior); el hilo empieza a
+    // preparar los dos primeros batches de inmediato
+    void start_epoch() { request_epoch(false, 0); }
+
+    // Igual, pero la epoca mezcla y aumenta con 'seed' partiendo del orden original, sin
+    // depender de las epocas anteriores (para reanudar un entrenamiento con el mismo orden)
+    void start_epoch(unsigned seed) { request_epoch(true, seed); }
+
+private:
+    void request_epoch(bool with_seed, unsigned seed) {
+        {
+            lock_guard<mutex> lock(mtx);
+            reseed = with_seed;
+            epoch_seed = seed;
+            held = -1;
+            for (auto &slot : slots) slot.ready = false;
+            consumed = 0;
+            error = nullptr;
+            ++epoch;
+            epoch_pending = true;
+        }
+        cv.notify_all();
+    }
+
+public:
+
+    // Entrega el siguiente batch (bloquea si aun no esta listo); false al terminar la epoca
+    bool next(const Tensor *&X, const Tensor *&Y) {
+        unique_lock<mutex> lock(mtx);
+        release_held();
+        if (consumed == num_batches()) {
+            return false;
+        }
+
+        const int slot = static_cast<int>(consumed % 2);
+        cv.wait(lock, [&] { return slots[slot].ready || error; });
+        if (error) {
+            rethrow_exception(error);
+        }
+
+        held = slot;
+        ++consumed;
+        X = &slots[slot].X;
+        Y = &slots[slot].Y;
+        return true;
+    }
+};
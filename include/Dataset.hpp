@@ -0,0 +1,220 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "Tensor.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Conjunto de datos que arma batches bajo demanda en tensores reutilizables:
+//   X: [n, sample_shape...]   Y: [n, label_size]
+class Dataset {
+public:
+    virtual ~Dataset() = default;
+
+    virtual size_t size() const = 0;
+    virtual const Shape &sample_shape() const = 0; // Forma de una muestra (sin el eje del batch)
+    virtual size_t label_size() const = 0;
+
+    // Copia las muestras indices[0..n) en X e Y (ya dimensionados con prepare_batch)
+    virtual void fill_batch(const size_t *indices, size_t n, Tensor &X, Tensor &Y) const = 0;
+
+    // Ajusta X e Y a un batch de n muestras; solo reserva memoria si la forma cambia
+    void prepare_batch(size_t n, Tensor &X, Tensor &Y) const {
+        Shape x_shape{n};
+        for (size_t dim : sample_shape()) x_shape.push_back(dim);
+        Shape y_shape{n, label_size()};
+        if (X.shape != x_shape) X = Tensor(x_shape);
+        if (Y.shape != y_shape) Y = Tensor(y_shape);
+    }
+
+    // Batch con las muestras consecutivas [start, end)
+    void get_batch(size_t start, size_t end, Tensor &X, Tensor &Y) const {
+        if (start >= end || end > size()) {
+            throw std::out_of_range("Dataset: rango de batch invalido");
+        }
+        vector<size_t> indices(end - start);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            indices[i] = start + i;
+        }
+        prepare_batch(indices.size(), X, Y);
+        fill_batch(indices.data(), indices.size(), X, Y);
+    }
+};
+
+// Adaptador sobre muestras ya cargadas como tensores (una por elemento del vector)
+// Sigue la misma convencion que stack_batch: [1, C, H, W] -> [C, H, W] por muestra
+class TensorDataset : public Dataset {
+private:
+    const vector<Tensor> &X;
+    const vector<Tensor> &Y;
+    Shape shape;
+
+public:
+    TensorDataset(const vector<Tensor> &X_, const vector<Tensor> &Y_) : X(X_), Y(Y_) {
+        if (X.size() != Y.size()) {
+            throw std::invalid_argument("TensorDataset: X e Y tienen distinto numero de muestras");
+        }
+        if (!X.empty()) {
+            const auto &first = X.front().shape;
+            if (first.size() == 4 && first[0] == 1) {
+                shape.assign(first.begin() + 1, first.end());
+            } else {
+                shape = first;
+            }
+        }
+    }
+
+    size_t size() const override { return X.size(); }
+    const Shape &sample_shape() const override { return shape; }
+    size_t label_size() const override { return Y.empty() ? 0 : Y.front().get_size(); }
+
+    void fill_batch(const size_t *indices, size_t n, Tensor &X_batch, Tensor &Y_batch) const override {
+        const size_t x_size = X_batch.get_size() / n;
+        const size_t y_size = label_size();
+        for (size_t i = 0; i < n; ++i) {
+            const Tensor &x = X[indices[i]];
+            const Tensor &y = Y[indices[i]];
+            if (x.get_size() != x_size || y.get_size() != y_size) {
+                throw std::runtime_error("TensorDataset: todas las muestras deben tener la misma forma");
+            }
+            std::copy(x.data.begin(), x.data.end(), X_batch.data.begin() + i * x_size);
+            std::copy(y.data.begin(), y.data.end(), Y_batch.data.begin() + i * y_size);
+        }
+    }
+};
+
+// Parte 'rank' de 'world' de otro dataset (muestras rank, rank + world, ...) para el
+// entrenamiento distribuido. Todas las partes tienen el mismo tamaño (se descartan las
+// muestras sobrantes) para que cada proceso haga el mismo numero de pasos
+class DatasetShard : public Dataset {
+private:
+    const Dataset &base;
+    size_t rank, world;
+
+public:
+    DatasetShard(const Dataset &base_, size_t rank_, size_t world_) : base(base_), rank(rank_), world(world_) {
+        if (world == 0 || rank >= world) {
+            throw std::invalid_argument("DatasetShard: rank fuera de rango");
+        }
+    }
+
+    size_t size() const override { return base.size() / world; }
+    const Shape &sample_shape() const override { return base.sample_shape(); }
+    size_t label_size() const override { return base.label_size(); }
+
+    void fill_batch(const size_t *indices, size_t n, Tensor &X, Tensor &Y) const override {
+        vector<size_t> mapped(n);
+        for (size_t i = 0; i < n; ++i) {
+            if (indices[i] >= size()) {
+                throw std::out_of_range("DatasetShard: indice fuera de rango");
+            }
+            mapped[i] = indices[i] * world + rank;
+        }
+        base.fill_batch(mapped.data(), n, X, Y);
+    }
+};
+
+// Forma de cada muestra de MNIST
+enum class SampleLayout {
+    FLAT,  // [rows * cols]       (MLP)
+    IMAGE  // [1, rows, cols]     (CNN)
+};
+
+// Dataset MNIST en el formato de convert.cpp, proyectado con mmap:
+//   header: (int32) num_images, (int32) rows, (int32) cols
+//   data:   por imagen (uchar) label, (uchar[rows*cols]) pixels
+// Solo existe la copia uint8 del archivo; la conversion a float / 255 y el one-hot
+// se hacen al llenar cada batch. slice() crea subconjuntos sin copiar datos.
+class MnistDataset : public Dataset {
+private:
+    static constexpr size_t HEADER_BYTES = 3 * sizeof(int32_t);
+    static constexpr size_t NUM_CLASSES = 10;
+
+    shared_ptr<const MappedFile> file; // Compartido entre los slices
+    size_t first = 0;                  // Primera muestra de este slice
+    size_t count = 0;                  // Muestras del slice
+    size_t rows = 0, cols = 0;
+    Shape shape;
+
+    const unsigned char *record(size_t i) const {
+        return file->data() + HEADER_BYTES + (first + i) * (1 + rows * cols);
+    }
+
+public:
+    explicit MnistDataset(const string &filename, SampleLayout layout = SampleLayout::IMAGE,
+                          size_t max_rows = static_cast<size_t>(-1))
+        : file(make_shared<const MappedFile>(filename)) {
+        if (file->size() < HEADER_BYTES) {
+            throw std::runtime_error("MnistDataset: archivo sin cabecera: " + filename);
+        }
+        int32_t header[3];
+        std::memcpy(header, file->data(), sizeof(header));
+        if (header[0] <= 0 || header[1] <= 0 || header[2] <= 0) {
+            throw std::runtime_error("MnistDataset: cabecera invalida en " + filename);
+        }
+
+        count = std::min(static_cast<size_t>(header[0]), max_rows);
+        rows = static_cast<size_t>(header[1]);
+        cols = static_cast<size_t>(header[2]);
+        if (file->size() < HEADER_BYTES + count * (1 + rows * cols)) {
+            throw std::runtime_error("MnistDataset: archivo truncado: " + filename);
+        }
+
+        if (layout == SampleLayout::IMAGE) {
+            shape = {1, rows, cols};
+        } else {
+            shape = {rows * cols};
+        }
+    }
+
+    // Subconjunto [begin, end) que comparte la misma proyeccion
+    MnistDataset slice(size_t begin, size_t end) const {
+        if (begin > end || end > count) {
+            throw std::out_of_range("MnistDataset: slice fuera de rango");
+        }
+        MnistDataset result(*this);
+        result.first = first + begin;
+        result.count = end - begin;
+        return result;
+    }
+
+    size_t size() const override { return count; }
+    const Shape &sample_shape() const override { return shape; }
+    size_t label_size() const override { return NUM_CLASSES; }
+
+    // Vistas sin copia de la muestra i
+    unsigned char label(size_t i) const { return record(i)[0]; }
+    const unsigned char *pixels(size_t i) const { return record(i) + 1; }
+
+    void fill_batch(const size_t *indices, size_t n, Tensor &X, Tensor &Y) const override {
+        const size_t image_size = rows * cols;
+        float *x = X.data.data();
+        float *y = Y.data.data();
+        std::fill(y, y + n * NUM_CLASSES, 0.0f);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (indices[i] >= count) {
+                throw std::out_of_range("MnistDataset: indice fuera de rango");
+            }
+            const unsigned char *src = record(indices[i]);
+            if (src[0] >= NUM_CLASSES) {
+                throw std::runtime_error("MnistDataset: etiqueta invalida");
+            }
+
+            // Normalizar a [0, 1] (mismo calculo que Reader::load_bin)
+            float *dst = x + i * image_size;
+            for (size_t j = 0; j < image_size; ++j) {
+                dst[j] = static_cast<float>(src[1 + j]) / 255.0f;
+            }
+            y[i * NUM_CLASSES + src[0]] = 1.0f;
+        }
+    }
+};
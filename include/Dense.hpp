@@ -8,32 +8,42 @@
 #include <random>
 #include <cmath>
 #include <algorithm>
+#include <iomanip>
+#include <sstream>
 
 // Capa densa (fully connected) para redes neuronales
 class Dense : public Layer {
 public:
     size_t input_dim;     // Dimension de entrada
     size_t output_dim;    // Dimension de salida
-    Tensor weights;       // Matriz de pesos [input_dim x output_dim]
+    Tensor weights;       // Matriz de pesos [input_dim x output_dim] (mismo orden que el archivo del modelo), fp32 o 16 bits
     Tensor bias;          // Vector de sesgos [output_dim]
-    string activation;    // Tipo de funcion de activacion
+    Activation activation; // Funcion de activacion
     float lambda;         // Coeficiente de regularizacion L2
 
-    // Cache para backpropagation
-    Tensor last_input;    // Entrada en forward pass
-    Tensor last_output;   // Salida pre-activacion
-    Tensor last_activated;// Salida post-activacion
+    // Cache para backpropagation (vistas sobre la arena de trabajo de la red)
+    ConstTensorView last_input; // Entrada en forward pass (sin copia)
+    TensorView last_output;     // Salida pre-activacion
+    TensorView last_activated;  // Salida post-activacion
+
+    enum Buffer { PRE_ACTIVATION, ACTIVATION, GRAD_Z, GRAD_INPUT }; // Buffers en la arena
     
     // Gradientes
     Tensor grad_weights;  // dL/dW
     Tensor grad_bias;     // dL/db
 
-    // Constructor: inicializa pesos y configura dimensiones
+    // Constructor: inicializa pesos y configura dimensiones.
+    // Con 'allocate' = false los tensores solo tienen la forma (para map_parameters)
     Dense(size_t input_dim_, size_t output_dim_, 
-          const string& activation_ = "", float lambda_ = 0.0f) 
+          Activation activation_ = Activation::LINEAR, float lambda_ = 0.0f, bool allocate = true) 
         : input_dim(input_dim_), output_dim(output_dim_),
           activation(activation_), lambda(lambda_) {
         
+        if (!allocate) {
+            weights = grad_weights = Tensor::unallocated({input_dim_, output_dim_});
+            bias = grad_bias = Tensor::unallocated({output_dim_});
+            return;
+        }
         weights = Tensor({input_dim_, output_dim_});
         bias = Tensor({output_dim_});
         grad_weights = Tensor({input_dim_, output_dim_});
@@ -42,6 +52,11 @@ public:
         initialize_weights_random_uniform(0.1f);
     }
 
+    // Activacion por nombre ("relu", "sigmoid", "tanh", "softmax"; "" o "linear": identidad)
+    Dense(size_t input_dim_, size_t output_dim_, const string& activation_, float lambda_ = 0.0f,
+          bool allocate = true)
+        : Dense(input_dim_, output_dim_, parse_activation(activation_), lambda_, allocate) {}
+
     // Inicializacion uniforme de pesos
     void initialize_weights_random_uniform(float range) {
         std::default_random_engine rng;
@@ -60,9 +75,20 @@ public:
         return lambda * sum;
     }
 
-    void scale_gradients(float scale) {
-        for (float& g : grad_weights.data) g *= scale;
-        for (float& g : grad_bias.data) g *= scale;
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<Dense>(*this); }
+
+    // Guardar configuracion de la capa (el tipo de los pesos solo si no es fp32)
+    void save(std::ostream& out) const override {
+        out << "Dense " << input_dim << " " << output_dim << " " << activation_name(activation)
+            << " " << std::setprecision(9) << lambda;
+        if (weights.dtype != DType::FLOAT32) out << " " << dtype_name(weights.dtype);
+        out << "\n";
+    }
+
+    // Pesos en 16 bits: el forward los lee asi (la mitad de ancho de banda en el GEMV);
+    // el bias queda en fp32
+    void set_precision(DType dtype, bool keep_master) override {
+        weights.set_dtype(dtype, keep_master);
     }
 
     // Reinicia gradientes a cero
@@ -71,111 +97,144 @@ public:
         grad_bias.fill(0.0f);
     }
 
-    // Forward pass: X -> (XW + b) -> activacion
-    Tensor forward(const Tensor& input) override {
-        last_input = input;
-        last_output = dot_product(input, weights);
-        
-        // Sumar bias
-        for (size_t i = 0; i < output_dim; ++i) {
-            last_output.data[i] += bias.data[i];
-        }
-        
-        // Aplicar activacion
-        last_activated = Tensor({output_dim});
-        if (activation == "softmax") {
-            last_activated = softmax(last_output);
-        } else {
-            for (size_t i = 0; i < output_dim; ++i) {
-                last_activated.data[i] = activation_function(last_output.data[i]);
-            }
+    // [input_dim] -> [output_dim]   o   [N, ...] (input_dim por muestra) -> [N, output_dim]
+    Shape output_shape(const Shape& input_shape) const override {
+        const size_t batch = (input_shape.size() == 1) ? 1 : input_shape[0];
+        if (input_shape.empty() || batch == 0 || input_shape.numel() != batch * input_dim) {
+            std::ostringstream msg;
+            msg << "Dense: se esperaban " << input_dim << " valores por muestra y la entrada es " << input_shape;
+            throw std::invalid_argument(msg.str());
         }
-        
+        return (input_shape.size() == 1) ? Shape{output_dim} : Shape{batch, output_dim};
+    }
+
+    void buffer_requests(const Shape& input_shape, vector<BufferRequest>& requests) const override {
+        const size_t out = output_shape(input_shape).numel();
+        requests.push_back({PRE_ACTIVATION, out, BufferUse::SAVED});
+        requests.push_back({ACTIVATION, out, BufferUse::OUTPUT});
+        requests.push_back({GRAD_Z, out, BufferUse::BACKWARD_SCRATCH});
+        requests.push_back({GRAD_INPUT, input_shape.numel(), BufferUse::GRAD_INPUT});
+    }
+
+    // Forward pass: guarda entrada, pre-activacion y activacion para el backward
+    ConstTensorView forward(ConstTensorView input) override {
+        last_input = input;
+        compute(input, forward_workspace(), last_output, last_activated);
         return last_activated;
     }
 
-    // Backward pass: calcula gradientes
-    Tensor backward(const Tensor& grad_output) override {
-        Tensor grad_input({input_dim});
-        
-        if (activation == "softmax") {
-            // Caso especial para softmax + cross-entropy
-            for (size_t i = 0; i < output_dim; ++i) {
-                float dz = grad_output.data[i];
-                grad_bias.data[i] += dz;
-                
-                for (size_t j = 0; j < input_dim; ++j) {
-                    grad_weights.data[j * output_dim + i] += dz * last_input.data[j];
-                    grad_input.data[j] += dz * weights.data[j * output_dim + i];
-                }
-            }
-        } else {
-            // Caso general para otras activaciones
-            for (size_t i = 0; i < output_dim; ++i) {
-                float dz = grad_output.data[i] * activation_derivative(last_output.data[i]);
-                grad_bias.data[i] += dz;
-                
-                for (size_t j = 0; j < input_dim; ++j) {
-                    grad_weights.data[j * output_dim + i] += dz * last_input.data[j];
-                    grad_input.data[j] += dz * weights.data[j * output_dim + i];
+    // Inferencia sin estado: mismos buffers de la arena, sin guardar nada en la capa
+    ConstTensorView infer(ConstTensorView input, Workspace& ws) const override {
+        TensorView pre_activation, activated;
+        compute(input, ws, pre_activation, activated);
+        return activated;
+    }
+
+    // Camino fusionado (Fusion.hpp): 'out' [rows, output_dim] = act(X * W + b) en un solo
+    // buffer; 'act' es la activacion de la capa o la de una capa de activacion que la sigue.
+    // Cada hilo aplica bias y activacion a sus bloques de GEMM_BLOCK_M filas apenas salen
+    // del GEMM, todavia en cache (softmax, que necesita la fila completa, al final)
+    void infer_rows(const float* input, size_t rows, float* out, Activation act) const {
+        const WeightsView w = parameter_view(0, weights);
+        const float* b = parameter_data(1, bias);
+        const simd::Kernels& kern = simd::kernels();
+        const bool softmax = act == Activation::SOFTMAX;
+
+        parallel_blocks(rows, output_dim, [&](size_t i0, size_t count, size_t j0, size_t cols) {
+            for (size_t r0 = i0; r0 < i0 + count; r0 += GEMM_BLOCK_M) {
+                const size_t block = std::min(GEMM_BLOCK_M, i0 + count - r0);
+                float* c = out + r0 * output_dim + j0;
+                gemm(input + r0 * input_dim, w.offset(j0), c, block, cols, input_dim, input_dim, output_dim, output_dim);
+                for (size_t n = 0; n < block; ++n) {
+                    float* row = c + n * output_dim;
+                    kern.axpy(1.0f, b + j0, row, cols);
+                    if (!softmax) {
+                        apply_activation(act, row, row, 1, cols);
+                    }
                 }
             }
+        });
+        if (softmax) {
+            apply_activation(act, out, out, rows, output_dim);
         }
+    }
+
+    // Backward pass: calcula gradientes acumulando sobre todas las filas del batch
+    // Con pesos [input_dim, output_dim] cada producto recorre memoria contigua:
+    //   dW[in, out] += X^T * dZ    (filas de dZ contiguas)
+    //   dX[N, in]    = dZ * W^T    (producto punto entre filas de dZ y de W)
+    ConstTensorView backward(ConstTensorView grad_output) override {
+        require_contiguous(grad_output, "Dense");
+        require_master(weights, "Dense");
+        size_t batch = batch_rows(last_input);
+        Workspace& ws = backward_workspace();
+        TensorView grad_input = ws.tensor(this, GRAD_INPUT, last_input.shape);
+
+        // dZ = dL/dY * f'(Z)  (softmax + cross-entropy ya llega simplificado)
+        const simd::Kernels& kern = simd::kernels();
+        TensorView grad_z = ws.tensor(this, GRAD_Z, last_output.shape);
+        const size_t total = grad_z.get_size();
+        std::copy(grad_output.data, grad_output.data + total, grad_z.data);
+        float* dz = grad_z.data;
+        apply_activation_grad(activation, last_output.data, dz, total);
+
+        // Gradiente del bias: suma de dZ sobre el batch
+        for (size_t n = 0; n < batch; ++n) {
+            kern.axpy(1.0f, dz + n * output_dim, grad_bias.data.data(), output_dim);
+        }
+
+        // dW += X^T * dZ
+        parallel_gemm(last_input.data, dz, grad_weights.data.data(),
+                      input_dim, output_dim, batch, true, false, true);
+        // dX = dZ * W^T
+        parallel_gemm(dz, weights.data.data(), grad_input.data,
+                      batch, input_dim, output_dim, false, true);
         
         // Regularizacion L2
         if (lambda > 0.0f) {
-            for (size_t i = 0; i < weights.data.size(); ++i) {
-                grad_weights.data[i] += 2 * lambda * weights.data[i];
-            }
+            kern.axpy(2 * lambda, weights.data.data(), grad_weights.data.data(), weights.data.size());
         }
         
         return grad_input;
     }
 
-    // Actualiza parametros usando optimizador
-    void update_parameters(Optimizer& optimizer) override {
-        optimizer.update(weights.data, grad_weights.data);
-        optimizer.update(bias.data, grad_bias.data);
+    // Parametros entrenables
+    void collect_parameters(vector<Parameter>& params) override {
+        params.push_back({&weights, &grad_weights});
+        params.push_back({&bias, &grad_bias});
     }
 
 private:
-    // Funciones de activacion
-    float activation_function(float x) const {
-        if (activation == "relu") return std::max(0.0f, x);
-        if (activation == "sigmoid") return 1.0f / (1.0f + exp(-x));
-        if (activation == "tanh") return tanh(x);
-        return x;  // Linear
-    }
-
-    // Derivadas de activacion
-    float activation_derivative(float x) const {
-        if (activation == "relu") return x > 0 ? 1.0f : 0.0f;
-        if (activation == "sigmoid") {
-            float s = 1.0f / (1.0f + exp(-x));
-            return s * (1.0f - s);
+    // Numero de filas del batch (1 si la entrada es un vector)
+    size_t batch_rows(const ConstTensorView& input) const {
+        size_t batch = (input.shape.size() == 1) ? 1 : input.shape[0];
+        if (input.get_size() != batch * input_dim) {
+            throw std::invalid_argument("Dense: la entrada no coincide con input_dim");
         }
-        if (activation == "tanh") {
-            float t = tanh(x);
-            return 1.0f - t * t;
-        }
-        return 1.0f;  // Linear
+        return batch;
     }
 
-    // Softmax con estabilidad numerica
-    Tensor softmax(const Tensor& input) {
-        Tensor result({output_dim});
-        float max_val = *std::max_element(input.data.begin(), input.data.end());
-        float sum_exp = 0.0f;
-        
-        for (size_t i = 0; i < output_dim; ++i) {
-            result.data[i] = exp(input.data[i] - max_val);
-            sum_exp += result.data[i];
-        }
-        
-        for (float& val : result.data) {
-            val /= sum_exp;
+    // X -> (XW + b) -> activacion, en los buffers de la arena
+    // Acepta un vector [input_dim] o un batch [N, input_dim]
+    void compute(ConstTensorView input, Workspace& ws, TensorView& pre_activation, TensorView& activated) const {
+        require_contiguous(input, "Dense");
+        size_t batch = batch_rows(input);
+
+        // Z[N, out] = X[N, in] * W[in, out]  (un vector 1D devuelve 1D)
+        const Shape out_shape = (input.shape.size() == 1) ? Shape{output_dim} : Shape{batch, output_dim};
+        pre_activation = ws.tensor(this, PRE_ACTIVATION, out_shape);
+        parallel_gemm(input.data, parameter_view(0, weights), pre_activation.data, batch, output_dim, input_dim);
+        const simd::Kernels& kern = simd::kernels();
+
+        // Sumar bias
+        const float* b = parameter_data(1, bias);
+        for (size_t n = 0; n < batch; ++n) {
+            kern.axpy(1.0f, b, pre_activation.data + n * output_dim, output_dim);
         }
-        
-        return result;
+
+        // Aplicar activacion sobre todo el buffer (softmax fila por fila)
+        activated = ws.tensor(this, ACTIVATION, out_shape);
+        apply_activation(activation, pre_activation.data, activated.data, batch, output_dim);
     }
+
 };
\ No newline at end of file
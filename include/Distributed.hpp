@@ -0,0 +1,320 @@
+#pragma once
+
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Comunicacion entre procesos para el entrenamiento distribuido. Los procesos (ranks)
+// forman un anillo por TCP: cada uno se conecta al siguiente y acepta al anterior.
+//   all_reduce: suma en anillo (reduce-scatter + all-gather); cada proceso envia y
+//               recibe 2 (P-1)/P veces el buffer, sin importar cuantos procesos haya.
+//               El orden de las sumas es fijo: todos obtienen exactamente el mismo resultado
+//   broadcast:  copia el buffer del rank 0 a todos
+// Las reducciones asincronas las hace un hilo propio en el orden en que se encolan
+// (el mismo en todos los procesos), asi que se solapan con el calculo.
+class RingCommunicator {
+private:
+    struct Job {
+        float *data;
+        size_t count;
+        float scale;
+    };
+
+    size_t rank_ = 0, world = 1;
+    int next_fd = -1, prev_fd = -1; // Conexiones con el siguiente y el anterior del anillo
+    int timeout_ms;
+    vector<float> scratch;          // Bloque recibido en el reduce-scatter
+
+    // Cola de reducciones asincronas (la atiende 'worker')
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable job_ready, jobs_done;
+    vector<Job> jobs;
+    size_t next_job = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    [[noreturn]] static void fail(const string &what) {
+        throw std::runtime_error("RingCommunicator: " + what + " (" + std::strerror(errno) + ")");
+    }
+
+    // "host:puerto" -> (host, puerto)
+    static pair<string, string> split_address(const string &address) {
+        const size_t colon = address.rfind(':');
+        if (colon == string::npos || colon + 1 == address.size()) {
+            throw std::invalid_argument("RingCommunicator: direccion sin puerto: " + address);
+        }
+        return {address.substr(0, colon), address.substr(colon + 1)};
+    }
+
+    static int listen_on(const string &port) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) fail("socket");
+        int yes = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(std::stoi(port)));
+        if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd, 4) != 0) {
+            ::close(fd);
+            fail("no se pudo escuchar en el puerto " + port);
+        }
+        return fd;
+    }
+
+    // Reintenta hasta que el siguiente proceso este escuchando (o se agote el tiempo)
+    int connect_to(const string &address) const {
+        const auto [host, port] = split_address(address);
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+        while (true) {
+            addrinfo *found = nullptr;
+            if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0) {
+                throw std::runtime_error("RingCommunicator: no se pudo resolver " + address);
+            }
+            int fd = ::socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+            const bool connected = fd >= 0 && ::connect(fd, found->ai_addr, found->ai_addrlen) == 0;
+            ::freeaddrinfo(found);
+            if (connected) return fd;
+            if (fd >= 0) ::close(fd);
+            if (std::chrono::steady_clock::now() > deadline) fail("no se pudo conectar con " + address);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+
+    int accept_from(int listener) const {
+        pollfd pfd{listener, POLLIN, 0};
+        if (::poll(&pfd, 1, timeout_ms) <= 0) {
+            throw std::runtime_error("RingCommunicator: el proceso anterior del anillo no se conecto");
+        }
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) fail("accept");
+        return fd;
+    }
+
+    void close_connections() {
+        if (next_fd >= 0) ::close(next_fd);
+        if (prev_fd >= 0) ::close(prev_fd);
+        next_fd = prev_fd = -1;
+    }
+
+    static void configure(int fd) {
+        int yes = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    // Envia al siguiente y recibe del anterior a la vez: si todos enviaran primero,
+    // el anillo se bloquearia con buffers mas grandes que los del kernel
+    void exchange(const void *send_buf, size_t send_bytes, void *recv_buf, size_t recv_bytes) {
+        const char *out = static_cast<const char *>(send_buf);
+        char *in = static_cast<char *>(recv_buf);
+        while (send_bytes > 0 || recv_bytes > 0) {
+            pollfd fds[2];
+            nfds_t n = 0;
+            if (send_bytes > 0) fds[n++] = {next_fd, POLLOUT, 0};
+            if (recv_bytes > 0) fds[n++] = {prev_fd, POLLIN, 0};
+            const int ready = ::poll(fds, n, timeout_ms);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready < 0) fail("poll");
+            if (ready == 0) throw std::runtime_error("RingCommunicator: tiempo de espera agotado");
+
+            for (nfds_t i = 0; i < n; ++i) {
+                if (fds[i].revents == 0) continue;
+                if (fds[i].fd == next_fd) {
+                    const ssize_t sent = ::send(next_fd, out, send_bytes, MSG_NOSIGNAL);
+                    if (sent < 0) {
+                        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                        fail("send");
+                    }
+                    out += sent;
+                    send_bytes -= static_cast<size_t>(sent);
+                } else {
+                    const ssize_t got = ::recv(prev_fd, in, recv_bytes, 0);
+                    if (got == 0) {
+                        throw std::runtime_error("RingCommunicator: el proceso anterior cerro la conexion");
+                    }
+                    if (got < 0) {
+                        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                        fail("recv");
+                    }
+                    in += got;
+                    recv_bytes -= static_cast<size_t>(got);
+                }
+            }
+        }
+    }
+
+    void reduce(float *data, size_t count) {
+        if (world == 1 || count == 0) return;
+        auto begin = [&](size_t block) { return block * count / world; };
+        auto bytes = [&](size_t block) { return (begin(block + 1) - begin(block)) * sizeof(float); };
+        scratch.resize((count + world - 1) / world);
+
+        // Reduce-scatter: en el paso s se envia el bloque (r - s) y se suma el (r - s - 1)
+        // recibido; al final el rank r tiene la suma completa del bloque (r + 1)
+        for (size_t step = 0; step + 1 < world; ++step) {
+            const size_t send_block = (rank_ + world - step) % world;
+            const size_t recv_block = (rank_ + 2 * world - step - 1) % world;
+            exchange(data + begin(send_block), bytes(send_block), scratch.data(), bytes(recv_block));
+            simd::kernels().axpy(1.0f, scratch.data(), data + begin(recv_block), bytes(recv_block) / sizeof(float));
+        }
+
+        // All-gather: cada bloque ya sumado recorre el anillo
+        for (size_t step = 0; step + 1 < world; ++step) {
+            const size_t send_block = (rank_ + 1 + world - step) % world;
+            const size_t recv_block = (rank_ + world - step) % world;
+            exchange(data + begin(send_block), bytes(send_block), data + begin(recv_block), bytes(recv_block));
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            job_ready.wait(lock, [&] { return stopping || next_job < jobs.size(); });
+            if (next_job == jobs.size()) return; // stopping sin trabajo pendiente
+
+            const Job job = jobs[next_job];
+            lock.unlock();
+            try {
+                reduce(job.data, job.count);
+                if (job.scale != 1.0f) {
+                    for (size_t i = 0; i < job.count; ++i) job.data[i] *= job.scale;
+                }
+            } catch (...) {
+                lock.lock();
+                error = std::current_exception();
+                jobs.clear();
+                next_job = 0;
+                jobs_done.notify_all();
+                continue;
+            }
+            lock.lock();
+            if (++next_job == jobs.size()) {
+                jobs.clear(); // Conserva la capacidad: en regimen estable no reserva memoria
+                next_job = 0;
+                jobs_done.notify_all();
+            }
+        }
+    }
+
+public:
+    // 'addresses' tiene una direccion "host:puerto" por rank; este proceso escucha en el
+    // puerto de la suya. Espera hasta 'timeout_seconds' a que los demas procesos arranquen
+    RingCommunicator(size_t rank, const vector<string> &addresses, double timeout_seconds = 60.0)
+        : rank_(rank), world(addresses.size()), timeout_ms(static_cast<int>(timeout_seconds * 1000)) {
+        if (world == 0 || rank >= world) {
+            throw std::invalid_argument("RingCommunicator: rank fuera de rango");
+        }
+        if (world > 1) {
+            const int listener = listen_on(split_address(addresses[rank]).second);
+            try {
+                next_fd = connect_to(addresses[(rank + 1) % world]);
+                prev_fd = accept_from(listener);
+                configure(next_fd);
+                configure(prev_fd);
+
+                // Cada conexion empieza con el rank de quien la abre
+                const uint32_t own = static_cast<uint32_t>(rank);
+                uint32_t peer = 0;
+                exchange(&own, sizeof(own), &peer, sizeof(peer));
+                if (peer != (rank + world - 1) % world) {
+                    throw std::runtime_error("RingCommunicator: se conecto un proceso que no es el anterior del anillo");
+                }
+            } catch (...) {
+                ::close(listener);
+                close_connections();
+                throw;
+            }
+            ::close(listener);
+        }
+        worker = std::thread(&RingCommunicator::run, this);
+    }
+
+    // Anillo de 'world' procesos en esta maquina: el rank r usa el puerto base_port + r
+    static vector<string> localhost(size_t world, int base_port) {
+        vector<string> addresses;
+        for (size_t r = 0; r < world; ++r) {
+            addresses.push_back("127.0.0.1:" + to_string(base_port + static_cast<int>(r)));
+        }
+        return addresses;
+    }
+
+    ~RingCommunicator() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        job_ready.notify_one();
+        worker.join();
+        close_connections();
+    }
+
+    RingCommunicator(const RingCommunicator &) = delete;
+    RingCommunicator &operator=(const RingCommunicator &) = delete;
+
+    size_t rank() const { return rank_; }
+    size_t size() const { return world; }
+
+    // Suma elemento a elemento de 'data' en todos los procesos (bloqueante)
+    void all_reduce(float *data, size_t count) {
+        wait();
+        reduce(data, count);
+    }
+
+    // Encola la suma de 'data' (multiplicada luego por 'scale'); el buffer no se debe
+    // tocar hasta wait(). Todos los procesos deben encolar lo mismo en el mismo orden
+    void all_reduce_async(float *data, size_t count, float scale = 1.0f) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back({data, count, scale});
+        }
+        job_ready.notify_one();
+    }
+
+    // Espera a que terminen las reducciones encoladas; relanza el error si alguna fallo
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobs_done.wait(lock, [&] { return jobs.empty() || error; });
+        if (error) {
+            std::exception_ptr failure = error;
+            error = nullptr;
+            std::rethrow_exception(failure);
+        }
+    }
+
+    // Copia 'data' del rank 0 a todos los procesos (bloqueante)
+    void broadcast(float *data, size_t count) {
+        wait();
+        if (world == 1) return;
+        const size_t bytes = count * sizeof(float);
+        if (rank_ != 0) exchange(nullptr, 0, data, bytes);
+        if ((rank_ + 1) % world != 0) exchange(data, bytes, nullptr, 0);
+    }
+};
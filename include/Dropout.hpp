@@ -4,6 +4,7 @@
 #include "Layer.hpp"
 #include "Optimizer.hpp"
 
+#include <iomanip>
 #include <random>
 #include <algorithm>
 #include <cmath>
@@ -14,7 +15,9 @@
 class Dropout : public Layer {
 private:
     float rate;       // Porcentaje de neuronas que se apagan
-    Tensor mask;      // Mascara binaria que indica que neuronas se apagan
+    TensorView mask;  // Mascara: 0 si la neurona se apaga, 1/(1-rate) si se mantiene (en la arena)
+
+    enum Buffer { MASK, OUTPUT, GRAD_INPUT }; // Buffers en la arena
     bool is_training; // Indica si esta en modo entrenamiento o inferencia
 
     // Generador aleatorio para aplicar dropout
@@ -34,59 +37,73 @@ public:
         is_training = training;
     }
 
+    void set_training(bool training) override { set_training_mode(training); }
+
+    // Semilla del generador de mascaras (cada replica data-parallel usa la suya)
+    void set_seed(unsigned seed) { rng.seed(seed); }
+
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<Dropout>(*this); }
+
     // Dropout no necesita gradientes propios
     void zero_grad() override {}
 
+    Shape output_shape(const Shape& input_shape) const override { return input_shape; }
+
+    void buffer_requests(const Shape& input_shape, vector<BufferRequest>& requests) const override {
+        const size_t count = input_shape.numel();
+        requests.push_back({MASK, count, BufferUse::SAVED});
+        requests.push_back({OUTPUT, count, BufferUse::OUTPUT});
+        requests.push_back({GRAD_INPUT, count, BufferUse::GRAD_INPUT});
+    }
+
+    // En inferencia la entrada pasa sin copiarse
+    bool may_alias_input() const override { return true; }
+
     // Propagacion hacia adelante
-    Tensor forward(const Tensor& input) override {
-        Tensor output = input; // Copia de entrada
-
-        if (is_training) {
-            mask = Tensor(input.shape); // Mascara del mismo tamaño
-            auto& mask_data = mask.data;
-            auto& output_data = output.data;
-            float scale = 1.0f / (1.0f - rate); // Escalado por dropout
-
-            // Aplicar dropout: si pasa el umbral, mantener la neurona
-            #pragma omp parallel for
-            for (size_t i = 0; i < input.get_size(); ++i) {
-                if (dist(rng) > rate) {
-                    mask_data[i] = 1.0f;
-                    output_data[i] *= scale;
-                } else {
-                    mask_data[i] = 0.0f;
-                    output_data[i] = 0.0f;
-                }
-            }
+    ConstTensorView forward(ConstTensorView input) override {
+        if (!is_training) {
+            return input; // En inferencia la entrada pasa sin copiarse
         }
-        return output; // En inferencia no se modifica la entrada
+        require_contiguous(input, "Dropout");
+
+        Workspace& ws = forward_workspace();
+        mask = ws.tensor(this, MASK, input.shape); // Mascara del mismo tamaño
+        TensorView output = ws.tensor(this, OUTPUT, input.shape);
+        float* mask_data = mask.data;
+        float scale = 1.0f / (1.0f - rate); // Escalado por dropout
+
+        // La mascara se genera en serie: el generador no es seguro entre hilos
+        for (size_t i = 0; i < input.get_size(); ++i) {
+            mask_data[i] = (dist(rng) > rate) ? scale : 0.0f;
+        }
+
+        // Aplicar dropout (ya escalado) con el kernel vectorial
+        simd::kernels().mul(input.data, mask_data, output.data, input.get_size());
+        return output;
+    }
+
+    // En inferencia el dropout es la identidad
+    ConstTensorView infer(ConstTensorView input, Workspace& ws) const override {
+        (void)ws;
+        return input;
     }
 
     // Propagacion hacia atras
-    Tensor backward(const Tensor& grad_output) override {
-        Tensor grad_input = grad_output; // Copia del gradiente de salida
-
-        if (is_training) {
-            const auto& mask_data = mask.data;
-            auto& grad_input_data = grad_input.data;
-            float scale = 1.0f / (1.0f - rate);
-
-            // Aplicar la misma mascara y escalado al gradiente
-            #pragma omp parallel for
-            for (size_t i = 0; i < grad_output.get_size(); ++i) {
-                grad_input_data[i] *= mask_data[i] * scale;
-            }
+    ConstTensorView backward(ConstTensorView grad_output) override {
+        if (!is_training) {
+            return grad_output;
         }
+        require_contiguous(grad_output, "Dropout");
 
+        // Aplicar la misma mascara (con el escalado incluido) al gradiente
+        TensorView grad_input = backward_workspace().tensor(this, GRAD_INPUT, grad_output.shape);
+        simd::kernels().mul(grad_output.data, mask.data, grad_input.data, grad_output.get_size());
         return grad_input;
     }
 
-    // Dropout no tiene parametros que actualizar
-    void update_parameters(Optimizer& optimizer) override {}
-
-    // Guardar capa en archivo
-    void save(std::ostream& out) const {
-        out << "Dropout " << rate << "\n";
+    // Guardar capa en archivo (con el estado del generador para reanudar igual)
+    void save(std::ostream& out) const override {
+        out << "Dropout " << std::setprecision(9) << rate << " " << rng << "\n";
     }
 
     // Cargar capa desde archivo
@@ -97,6 +114,10 @@ public:
             throw std::runtime_error("Error al cargar la capa: Se esperaba 'Dropout'");
         }
         in >> rate;
+        std::default_random_engine state;
+        if (in >> std::ws >> state) { // std::ws: el operador del generador no salta espacios
+            rng = state; // Estado del generador (opcional)
+        }
         dist = std::uniform_real_distribution<float>(0.0f, 1.0f);
         is_training = true;
     }
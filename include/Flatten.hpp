@@ -1,38 +1,45 @@
 #pragma once
 #include "Layer.hpp"
 
-// Capa Flatten para aplanar tensores multidimensionales a 1D
+// Capa Flatten para aplanar tensores multidimensionales
+// Conserva el eje de batch: [N, C, H, W] -> [N, C*H*W]
+// Forward y backward solo cambian la forma de la vista (sin copiar datos)
 class Flatten : public Layer {
 public:
-    vector<size_t> input_shape;  // Guarda la forma original para reshape en backward
+    Shape input_shape;      // Guarda la forma original para reshape en backward
 
-    // Forward pass: aplana el input a 1D
-    Tensor forward(const Tensor& input) override {
+    // Forward pass: aplana cada muestra del batch a 1D
+    ConstTensorView forward(ConstTensorView input) override {
         input_shape = input.shape; // Guardar forma original
-        
-        // Calcular tamaño total
-        size_t total_size = 1;
-        for (auto dim : input_shape) {
-            total_size *= dim;
-        }
-        
-        // Crear tensor 1D
-        Tensor output({total_size});
-        output.data = input.data; // Compartir datos (no copiar)
-        
-        return output;
+        return input.flatten();    // Un vector 1D ya esta aplanado
+    }
+
+    ConstTensorView infer(ConstTensorView input, Workspace& ws) const override {
+        (void)ws;
+        return input.flatten();
     }
 
     // Backward pass: restaura la forma original
-    Tensor backward(const Tensor& grad_output) override {
-        Tensor grad_input(input_shape);
-        grad_input.data = grad_output.data; // Compartir datos (no copiar)
-        return grad_input;
+    ConstTensorView backward(ConstTensorView grad_output) override {
+        return grad_output.reshape(input_shape);
     }
 
-    // No hay parámetros para actualizar
-    void update_parameters(Optimizer& optimizer) override {}
+    // [N, d1, d2, ...] -> [N, d1*d2*...]
+    Shape output_shape(const Shape& input_shape) const override {
+        if (input_shape.size() < 2) {
+            return input_shape;
+        }
+        return {input_shape[0], input_shape.numel() / input_shape[0]};
+    }
+
+    bool may_alias_input() const override { return true; }
+
+    bool backward_reads_input() const override { return false; }
+
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<Flatten>(*this); }
+
+    void save(std::ostream& out) const override { out << "Flatten\n"; }
 
     // No hay gradientes que reiniciar
     void zero_grad() override {}
-};
\ No newline at end of file
+};
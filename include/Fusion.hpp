@@ -0,0 +1,221 @@
+#pragma once
+
+#include "Activation.hpp"
+#include "Conv2D.hpp"
+#include "Dense.hpp"
+#include "Dropout.hpp"
+#include "Layer.hpp"
+#include "Pool2D.hpp"
+#include "Threads.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Fusion de capas para inferencia. NeuralNetwork arma con fuse_layers() la secuencia de
+// pasos que recorren infer() y predict(); las capas de la red no cambian (entrenamiento,
+// guardado). Los pasos fusionados referencian sus capas y leen los pesos al ejecutarse,
+// asi que siguen valiendo tras cada paso del optimizador, set_precision o map_model.
+// - Conv2D (bias y activacion) + Pooling2D -> FusedConvPool: por bandas de filas que
+//   caben en cache; la salida completa de la convolucion nunca se escribe
+// - Dense (bias y activacion) -> FusedDense: un solo buffer, epilogo por bloque de filas
+// - Capa de activacion (Activation.hpp) tras una Dense o Conv2D lineal: pasa a ser la
+//   activacion del paso fusionado
+// - Dropout: en inferencia es la identidad y no entra a la secuencia
+
+// Paso de la secuencia de inferencia que reemplaza a una o mas capas: solo infer()
+class FusedLayer : public Layer {
+public:
+    ConstTensorView forward(ConstTensorView input) override { return infer(input, forward_workspace()); }
+
+    ConstTensorView backward(ConstTensorView grad_output) override {
+        (void)grad_output;
+        throw std::runtime_error("Capa fusionada: solo inferencia");
+    }
+
+    std::unique_ptr<Layer> clone() const override {
+        throw std::runtime_error("Capa fusionada: se rearma desde las capas de la red");
+    }
+
+    void save(std::ostream& out) const override {
+        (void)out;
+        throw std::runtime_error("Capa fusionada: se guardan las capas de la red");
+    }
+
+    void zero_grad() override {}
+};
+
+// Bytes de la salida de la convolucion por banda de FusedConvPool (en cache hasta el pooling)
+constexpr size_t FUSED_TILE_BYTES = 256 * 1024;
+
+// Conv2D -> bias -> activacion ('act') -> Pooling2D. Cada banda son filas de salida del pooling de
+// una muestra: la convolucion calcula solo las filas que esas ventanas leen (Conv2D::infer_rows)
+// en un tile propio del hilo y el pooling lo reduce a la salida. Las bandas se reparten
+// entre hilos (con batch pequeño son mas chicas para que alcancen para todos)
+class FusedConvPool : public FusedLayer {
+public:
+    FusedConvPool(const Conv2D& conv_, const Pooling2D& pool_, Activation act_)
+        : conv(conv_), pool(pool_), act(act_) {}
+
+    Shape output_shape(const Shape& input_shape) const override {
+        return pool.output_shape(conv.output_shape(input_shape));
+    }
+
+    void buffer_requests(const Shape& input_shape, vector<BufferRequest>& requests) const override {
+        const Bands bands = plan_bands(input_shape);
+        requests.push_back({OUTPUT, output_shape(input_shape).numel(), BufferUse::OUTPUT});
+        requests.push_back({TILES, bands.threads * bands.tile_floats, BufferUse::FORWARD_SCRATCH});
+    }
+
+    ConstTensorView infer(ConstTensorView input, Workspace& ws) const override {
+        require_contiguous(input, "FusedConvPool");
+        const Shape conv_shape = conv.output_shape(input.shape);
+        const Shape out_shape = pool.output_shape(conv_shape);
+        const size_t batch = input.shape[0], height = input.shape[2], width = input.shape[3];
+        const size_t channels = conv_shape[1], conv_height = conv_shape[2], conv_width = conv_shape[3];
+        const size_t out_height = out_shape[2], out_width = out_shape[3];
+        const size_t image_size = input.get_size() / batch;
+
+        const Bands bands = plan_bands(input.shape);
+        TensorView output = ws.tensor(this, OUTPUT, out_shape);
+        float* tiles = ws.allocate(this, TILES, bands.threads * bands.tile_floats);
+
+        #pragma omp parallel for if(bands.threads > 1) num_threads(bands.threads) schedule(static)
+        for (size_t item = 0; item < batch * bands.count; ++item) {
+            const size_t b = item / bands.count;
+            const size_t pool_begin = (item % bands.count) * bands.rows;
+            const size_t pool_end = std::min(out_height, pool_begin + bands.rows);
+
+            // Filas de la convolucion que leen las ventanas de la banda
+            size_t row_begin = pool_begin * pool.stride;
+            const size_t row_end = (pool_end - 1) * pool.stride + pool.pool_size;
+            if (conv.use_winograd()) {
+                row_begin -= row_begin % 2; // Tiles de Winograd de 2 filas
+            }
+
+            float* tile = tiles + thread_index() * bands.tile_floats; // [canales, filas, conv_width]
+            float* scratch = tile + channels * bands.conv_rows * conv_width;
+            conv.infer_rows(input.data + b * image_size, height, width, row_begin, row_end, tile, scratch, act);
+
+            for (size_t c = 0; c < channels; ++c) {
+                pool.pool_rows(tile + c * (row_end - row_begin) * conv_width, row_begin, conv_height, conv_width,
+                               pool_begin, pool_end,
+                               output.data + ((b * channels + c) * out_height + pool_begin) * out_width, out_width);
+            }
+        }
+        return output;
+    }
+
+private:
+    enum Buffer { OUTPUT, TILES };
+
+    const Conv2D& conv;
+    const Pooling2D& pool;
+    Activation act;
+
+    struct Bands {
+        size_t rows;        // Filas de salida del pooling por banda
+        size_t count;       // Bandas por muestra
+        size_t conv_rows;   // Maximo de filas de la convolucion por banda
+        size_t tile_floats; // Tile + scratch de la convolucion (por hilo)
+        size_t threads;
+    };
+
+    Bands plan_bands(const Shape& input_shape) const {
+        const Shape conv_shape = conv.output_shape(input_shape);
+        const size_t batch = input_shape[0], width = input_shape[3];
+        const size_t out_height = pool.output_shape(conv_shape)[2];
+        const size_t row_floats = conv_shape[1] * conv_shape[3]; // Una fila de la convolucion (todos los canales)
+        const size_t max_threads = in_parallel_region() ? 1 : static_cast<size_t>(thread_count());
+
+        auto conv_rows = [&](size_t rows) { return (rows - 1) * pool.stride + pool.pool_size + 1; };
+
+        // El limite es para las filas de la convolucion que lee el pooling; las columnas de
+        // la convolucion (im2col o Winograd) van aparte, con bandas mas chicas el GEMM rinde menos
+        Bands bands;
+        bands.rows = out_height;
+        while (bands.rows > 1 && conv_rows(bands.rows) * row_floats * sizeof(float) > FUSED_TILE_BYTES) {
+            bands.rows = (bands.rows + 1) / 2;
+        }
+        if (batch < max_threads) {
+            bands.rows = std::min(bands.rows, std::max<size_t>(1, batch * out_height / max_threads));
+        }
+        bands.count = (out_height + bands.rows - 1) / bands.rows;
+        bands.conv_rows = conv_rows(bands.rows);
+        bands.tile_floats = simd::align_floats(bands.conv_rows * row_floats + conv.rows_scratch(width, bands.conv_rows));
+        bands.threads = (batch * bands.count >= max_threads) ? max_threads : 1;
+        return bands;
+    }
+};
+
+// Dense -> bias -> activacion ('act') en un solo buffer (Dense::infer_rows)
+class FusedDense : public FusedLayer {
+public:
+    FusedDense(const Dense& dense_, Activation act_) : dense(dense_), act(act_) {}
+
+    Shape output_shape(const Shape& input_shape) const override { return dense.output_shape(input_shape); }
+
+    void buffer_requests(const Shape& input_shape, vector<BufferRequest>& requests) const override {
+        requests.push_back({OUTPUT, output_shape(input_shape).numel(), BufferUse::OUTPUT});
+    }
+
+    ConstTensorView infer(ConstTensorView input, Workspace& ws) const override {
+        require_contiguous(input, "FusedDense");
+        TensorView output = ws.tensor(this, OUTPUT, output_shape(input.shape));
+        dense.infer_rows(input.data, input.get_size() / dense.input_dim, output.data, act);
+        return output;
+    }
+
+private:
+    enum Buffer { OUTPUT };
+
+    const Dense& dense;
+    Activation act;
+};
+
+// Secuencia de inferencia de 'layers': los pasos fusionados quedan en 'fused' (que los
+// posee) y la secuencia apunta a ellos o a las capas originales
+inline vector<const Layer*> fuse_layers(const vector<unique_ptr<Layer>>& layers, vector<unique_ptr<Layer>>& fused) {
+    vector<const Layer*> chain;
+    for (const auto& layer : layers) {
+        if (!dynamic_cast<const Dropout*>(layer.get())) {
+            chain.push_back(layer.get());
+        }
+    }
+
+    fused.clear();
+    vector<const Layer*> steps;
+    for (size_t i = 0; i < chain.size(); ++i) {
+        const auto* conv = dynamic_cast<const Conv2D*>(chain[i]);
+        const auto* dense = dynamic_cast<const Dense*>(chain[i]);
+
+        // Capa de activacion que sigue a una Dense o Conv2D lineal (softmax solo tras Dense)
+        const ActivationLayer* folded = nullptr;
+        if ((conv && conv->activation == Activation::LINEAR) || (dense && dense->activation == Activation::LINEAR)) {
+            folded = (i + 1 < chain.size()) ? dynamic_cast<const ActivationLayer*>(chain[i + 1]) : nullptr;
+            if (folded && conv && folded->activation == Activation::SOFTMAX) {
+                folded = nullptr;
+            }
+        }
+
+        if (conv) {
+            const size_t next = i + (folded ? 2 : 1);
+            const auto* pool = (next < chain.size()) ? dynamic_cast<const Pooling2D*>(chain[next]) : nullptr;
+            if (!pool) {
+                steps.push_back(chain[i]); // La activacion queda como paso propio
+                continue;
+            }
+            fused.push_back(std::make_unique<FusedConvPool>(*conv, *pool, folded ? folded->activation : conv->activation));
+            i = next;
+        } else if (dense) {
+            fused.push_back(std::make_unique<FusedDense>(*dense, folded ? folded->activation : dense->activation));
+            i += folded ? 1 : 0;
+        } else {
+            steps.push_back(chain[i]);
+            continue;
+        }
+        steps.push_back(fused.back().get());
+    }
+    return steps;
+}
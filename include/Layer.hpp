@@ -1,22 +1,165 @@
 #pragma once
 
 #include "Tensor.hpp"
+#include "TensorView.hpp"
+#include "Workspace.hpp"
 #include "Optimizer.hpp"
 
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+// Datos de una capa que no son parametros entrenables (p. ej. pesos int8 ya
+// cuantizados): se guardan y cargan con el modelo
+struct LayerBuffer {
+    DType dtype;
+    Shape shape;
+    void* data;
+    size_t bytes;
+};
+
 // Clase base abstracta para todas las capas de una red neuronal
+// Entradas y salidas son vistas: la salida apunta a la arena de trabajo de la red
+// (o a la misma entrada, p. ej. Flatten) y es valida hasta el siguiente paso.
+// La entrada de forward debe seguir viva hasta el backward correspondiente.
+// infer() es el camino de inferencia: no modifica la capa y solo escribe en la
+// arena que recibe, asi que varios hilos pueden usar la misma red (cada uno con su arena).
 class Layer {
 public:
+    Layer() = default;
+    // Una copia no hereda la arena: la asigna la red que la recibe
+    Layer(const Layer& other) : mapped(other.mapped) {}
+    Layer& operator=(const Layer&) = delete;
     virtual ~Layer() = default;
 
+    // Copia independiente (pesos, configuracion y buffers de gradiente propios);
+    // la usan las replicas del entrenamiento data-parallel
+    virtual std::unique_ptr<Layer> clone() const = 0;
+
+    // Configuracion de la capa en una linea de texto: tipo y argumentos del constructor
+    // (p. ej. "Dense 392 32 relu 0"). El archivo del modelo la usa para reconstruir la red
+    virtual void save(std::ostream& out) const = 0;
+
     // Procesa la entrada y devuelve la salida de la capa
-    virtual Tensor forward(const Tensor& input) = 0;
+    virtual ConstTensorView forward(ConstTensorView input) = 0;
+
+    // Salida en modo inferencia sin guardar estado; los buffers salen de 'ws'
+    virtual ConstTensorView infer(ConstTensorView input, Workspace& ws) const = 0;
 
     // Calcula los gradientes respecto a la entrada y pesos
-    virtual Tensor backward(const Tensor& grad_output) = 0;
+    virtual ConstTensorView backward(ConstTensorView grad_output) = 0;
+
+    // Agrega los parametros entrenables (valor + gradiente) de la capa;
+    // el optimizador los actualiza todos juntos en un solo paso
+    virtual void collect_parameters(vector<Parameter>& params) { (void)params; }
 
-    // Actualiza los parámetros usando el optimizador
-    virtual void update_parameters(Optimizer& optimizer) = 0;
+    // Se llama despues de cada paso del optimizador (p. ej. para invalidar caches)
+    virtual void parameters_updated() {}
+
+    // Agrega los buffers no entrenables que se guardan con el modelo. Al cargar el
+    // modelo se escriben en 'data' y despues se llama a parameters_updated()
+    virtual void collect_buffers(vector<LayerBuffer>& buffers) { (void)buffers; }
+
+    // Tipo de almacenamiento de los pesos (Tensor::set_dtype): FLOAT32, BF16 o FP16.
+    // Los kernels leen los pesos en ese tipo y acumulan en fp32. Con 'keep_master' los
+    // tensores conservan la copia fp32 (red que se sigue entrenando)
+    virtual void set_precision(DType dtype, bool keep_master) {
+        (void)dtype;
+        (void)keep_master;
+    }
+
+    // Usa parametros de solo lectura que no son de la capa (p. ej. un modelo proyectado
+    // con mmap): un puntero por parametro, en el orden de collect_parameters y en el tipo
+    // de almacenamiento de cada tensor. La capa libera sus tensores (conservan la forma)
+    // y desde entonces solo sirve para inferencia; la memoria apuntada debe vivir
+    // mientras se use la capa
+    void map_parameters(const vector<const void*>& data) {
+        vector<Parameter> params;
+        collect_parameters(params);
+        if (data.size() != params.size()) {
+            throw std::invalid_argument("map_parameters: la capa tiene " + std::to_string(params.size()) +
+                                        " parametros y se recibieron " + std::to_string(data.size()));
+        }
+        for (Parameter& param : params) {
+            param.value->release();
+            param.grad->release();
+        }
+        mapped = data;
+        parameters_updated();
+    }
+
+    // Los parametros son de solo lectura (map_parameters): la capa no se puede entrenar
+    bool is_mapped() const { return !mapped.empty(); }
 
     // Reinicia los gradientes acumulados a cero
     virtual void zero_grad() = 0;
+
+    // Forma de la salida para una entrada dada (con el eje del batch);
+    // lanza invalid_argument si la entrada no es compatible con la capa
+    virtual Shape output_shape(const Shape& input_shape) const = 0;
+
+    // Buffers que la capa pide a la arena para una entrada dada (para el plan de memoria)
+    virtual void buffer_requests(const Shape& input_shape, vector<BufferRequest>& requests) const {
+        (void)input_shape;
+        (void)requests;
+    }
+
+    // La salida puede ser una vista de la entrada (y el gradiente de entrada una
+    // vista del de salida), p. ej. Flatten
+    virtual bool may_alias_input() const { return false; }
+
+    // El backward lee la entrada del forward. Si no (Pooling2D guarda sus propios indices),
+    // el plan de memoria libera esa entrada cuando termina el forward
+    virtual bool backward_reads_input() const { return true; }
+
+    // Modo entrenamiento / inferencia (solo lo usan capas como Dropout)
+    virtual void set_training(bool training) { (void)training; }
+
+    // Arena compartida por todas las capas de la red (la asigna NeuralNetwork)
+    void set_workspace(Workspace* ws) { workspace = ws; }
+
+protected:
+    // Arena para los buffers de forward. Una capa usada fuera de una red tiene la
+    // suya propia y la reinicia en cada forward (cada forward es un paso nuevo)
+    Workspace& forward_workspace() {
+        if (workspace) return *workspace;
+        own_workspace.reset();
+        return own_workspace;
+    }
+
+    // Arena para los buffers de backward (mismo paso que el forward anterior)
+    Workspace& backward_workspace() {
+        return workspace ? *workspace : own_workspace;
+    }
+
+    // Datos del parametro 'index' (orden de collect_parameters): los del tensor propio
+    // o los proyectados con map_parameters. parameter_data solo para tensores fp32
+    WeightsView parameter_view(size_t index, const Tensor& own) const {
+        return mapped.empty() ? own.storage() : WeightsView{mapped[index], own.dtype};
+    }
+
+    const float* parameter_data(size_t index, const Tensor& own) const {
+        return parameter_view(index, own).f32();
+    }
+
+    // El backward usa los pesos en fp32: con pesos en 16 bits, la copia maestra que
+    // crea el optimizador al registrarlos (compile)
+    static void require_master(const Tensor& weights, const char* layer) {
+        if (weights.data.size() != weights.shape.numel()) {
+            throw std::runtime_error(std::string(layer) + ": pesos sin copia fp32 para el backward (compilar la red "
+                                     "antes de entrenar; un modelo proyectado es solo de inferencia)");
+        }
+    }
+
+    // Los kernels de las capas recorren la memoria de forma lineal
+    static void require_contiguous(const ConstTensorView& view, const char* layer) {
+        if (!view.is_contiguous()) {
+            throw std::invalid_argument(std::string(layer) + ": se esperaba una vista contigua");
+        }
+    }
+
+private:
+    Workspace* workspace = nullptr;
+    Workspace own_workspace;
+    vector<const void*> mapped; // Parametros proyectados (vacio: los tensores propios)
 };
\ No newline at end of file
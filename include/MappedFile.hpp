@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Archivo proyectado en memoria (solo lectura). Las paginas se cargan bajo demanda
+// y las comparte el cache del sistema operativo, sin copias en el heap.
+class MappedFile {
+private:
+    const unsigned char *base = nullptr;
+    size_t length = 0;
+
+public:
+    explicit MappedFile(const std::string &filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("No se pudo abrir el archivo: " + filename + " (" + std::strerror(errno) + ")");
+        }
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("No se pudo leer el tamaño de: " + filename);
+        }
+        length = static_cast<size_t>(info.st_size);
+
+        if (length > 0) {
+            void *ptr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("mmap fallo para: " + filename + " (" + std::strerror(errno) + ")");
+            }
+            base = static_cast<const unsigned char *>(ptr);
+        }
+        ::close(fd); // La proyeccion sigue valida sin el descriptor
+    }
+
+    ~MappedFile() {
+        if (base) {
+            ::munmap(const_cast<unsigned char *>(base), length);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const unsigned char *data() const { return base; }
+    size_t size() const { return length; }
+
+    // Sugerencia de patron de acceso al kernel (p. ej. MADV_SEQUENTIAL / MADV_RANDOM)
+    void advise(int advice) const {
+        if (base) {
+            ::madvise(const_cast<unsigned char *>(base), length, advice);
+        }
+    }
+};
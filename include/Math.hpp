@@ -1,56 +1,341 @@
 #pragma once
 #include "Tensor.hpp"
+#include "Simd.hpp"
+#include "Threads.hpp"
 #include <cmath>
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
+#include <string>
 #include <omp.h>
 
-// Realiza el producto punto entre dos tensores:
-// - 'a': Tensor de entrada (1D)
-// - 'b': Tensor de pesos (2D, forma [N, M])
-// Retorna un nuevo tensor con el resultado (1D, tamaño M)
-Tensor dot_product(const Tensor &a, const Tensor &b) {
-    const auto& a_data = a.data;      // Acceso directo a los datos
-    const auto& b_data = b.data;
-    const auto& b_shape = b.shape;
+// Devuelve el índice del elemento con mayor valor en un bloque contiguo
+// (maximo vectorizado y luego la primera posicion que lo contiene)
+inline int argmax(const float* data, size_t size) {
+    const float max_val = simd::kernels().max_value(data, size);
     
-    // Dimensiones del producto punto
-    size_t N = b_shape[0];  // dim. entrada
-    size_t M = b_shape[1];  // dim. salida
-
-    Tensor result({M});     // Tensor resultado
-    
-    // Paraleliza el cálculo con OpenMP
-    #pragma omp parallel for
-    for (size_t i = 0; i < M; i++) {
-        float sum = 0.0f;
-        for (size_t j = 0; j < N; j++) {
-            // Formula del producto punto
-            sum += a_data[j] * b_data[j * M + i]; 
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] == max_val) {
+            return static_cast<int>(i);
         }
-        result.data[i] = sum;
     }
     
-    return result;
+    return 0;
 }
 
-
 // Devuelve el índice del elemento con mayor valor en el tensor
 inline int argmax(const Tensor& tensor) {
     if (tensor.data.empty()) {
         throw std::runtime_error("Tensor vacío en argmax");
     }
     
-    const auto& data = tensor.data;
-    int max_index = 0;
-    float max_val = data[0];
-    
-    for (size_t i = 1; i < data.size(); ++i) {
-        if (data[i] > max_val) {
-            max_val = data[i];
-            max_index = static_cast<int>(i);
+    return argmax(tensor.data.data(), tensor.data.size());
+}
+
+// Tamaños de bloque de la multiplicacion de matrices (un bloque de B cabe en L2)
+constexpr size_t GEMM_BLOCK_M = 64;
+constexpr size_t GEMM_BLOCK_N = 256;
+constexpr size_t GEMM_BLOCK_K = 128;
+
+// Camino de gemm sin transponer B: C[i, :] += A[i, k] * B[k, :], recorriendo cada fila
+// de B de forma contigua. 'a_at(i, k)' lee A y 'axpy_row(a, k, j0, c, n)' suma
+// a * B[k, j0:j0+n] en c (asi B puede estar en fp32 o en 16 bits)
+template <typename LoadA, typename AxpyRow>
+inline void gemm_rows(LoadA a_at, AxpyRow axpy_row, float *C, size_t M, size_t N, size_t K, size_t ldc) {
+    for (size_t j0 = 0; j0 < N; j0 += GEMM_BLOCK_N) {
+        size_t j1 = std::min(j0 + GEMM_BLOCK_N, N);
+        for (size_t k0 = 0; k0 < K; k0 += GEMM_BLOCK_K) {
+            size_t k1 = std::min(k0 + GEMM_BLOCK_K, K);
+            for (size_t i0 = 0; i0 < M; i0 += GEMM_BLOCK_M) {
+                size_t i1 = std::min(i0 + GEMM_BLOCK_M, M);
+                for (size_t i = i0; i < i1; ++i) {
+                    float *c_row = C + i * ldc;
+                    for (size_t k = k0; k < k1; ++k) {
+                        axpy_row(a_at(i, k), k, j0, c_row + j0, j1 - j0);
+                    }
+                }
+            }
         }
     }
-    
-    return max_index;
-}
\ No newline at end of file
+}
+
+// Multiplicacion de matrices por bloques (row-major):
+//   C[M, N] = op(A)[M, K] * op(B)[K, N]   (se suma a C si 'accumulate')
+// - trans_a: A se guarda como [K, M]
+// - trans_b: B se guarda como [N, K]
+// - lda/ldb/ldc: paso entre filas de cada matriz (0 = matriz compacta)
+// El bucle interno siempre recorre memoria contigua y usa los kernels SIMD (dot / axpy)
+inline void gemm(const float *A, const float *B, float *C, size_t M, size_t N, size_t K,
+                 bool trans_a = false, bool trans_b = false, bool accumulate = false,
+                 size_t lda = 0, size_t ldb = 0, size_t ldc = 0) {
+    if (trans_a && trans_b) {
+        throw std::invalid_argument("gemm: no se soporta transponer A y B a la vez");
+    }
+    if (lda == 0) lda = trans_a ? M : K;
+    if (ldb == 0) ldb = trans_b ? K : N;
+    if (ldc == 0) ldc = N;
+
+    if (!accumulate) {
+        for (size_t i = 0; i < M; ++i) {
+            std::fill(C + i * ldc, C + i * ldc + N, 0.0f);
+        }
+    }
+
+    const simd::Kernels &kern = simd::kernels();
+
+    if (trans_b) {
+        // C[i, j] += <fila i de A, fila j de B>: producto punto contiguo sobre K
+        for (size_t i0 = 0; i0 < M; i0 += GEMM_BLOCK_M) {
+            size_t i1 = std::min(i0 + GEMM_BLOCK_M, M);
+            for (size_t j0 = 0; j0 < N; j0 += GEMM_BLOCK_N) {
+                size_t j1 = std::min(j0 + GEMM_BLOCK_N, N);
+                for (size_t k0 = 0; k0 < K; k0 += GEMM_BLOCK_K) {
+                    size_t k1 = std::min(k0 + GEMM_BLOCK_K, K);
+                    for (size_t i = i0; i < i1; ++i) {
+                        const float *a_row = A + i * lda;
+                        for (size_t j = j0; j < j1; ++j) {
+                            C[i * ldc + j] += kern.dot(a_row + k0, B + j * ldb + k0, k1 - k0);
+                        }
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    gemm_rows([&](size_t i, size_t k) { return trans_a ? A[k * lda + i] : A[i * lda + k]; },
+              [&](float a, size_t k, size_t j0, float *c, size_t n) { kern.axpy(a, B + k * ldb + j0, c, n); },
+              C, M, N, K, ldc);
+}
+
+// gemm con una de las matrices (los pesos) en fp32 o en 16 bits, sin transponer:
+// los valores de 16 bits se convierten al leerlos y se acumula en fp32
+//   C[M, N] = A[M, K] * B[K, N]   con B en WeightsView (p. ej. Dense)
+//   C[M, N] = A[M, K] * B[K, N]   con A en WeightsView (p. ej. Conv2D)
+inline void gemm(const float *A, WeightsView B, float *C, size_t M, size_t N, size_t K,
+                 size_t lda = 0, size_t ldb = 0, size_t ldc = 0) {
+    if (!is_half(B.dtype)) {
+        gemm(A, B.f32(), C, M, N, K, false, false, false, lda, ldb, ldc);
+        return;
+    }
+    if (lda == 0) lda = K;
+    if (ldb == 0) ldb = N;
+    if (ldc == 0) ldc = N;
+    for (size_t i = 0; i < M; ++i) {
+        std::fill(C + i * ldc, C + i * ldc + N, 0.0f);
+    }
+    const auto axpy = B.dtype == DType::BF16 ? simd::kernels().axpy_bf16 : simd::kernels().axpy_fp16;
+    const uint16_t *b = B.f16();
+    gemm_rows([&](size_t i, size_t k) { return A[i * lda + k]; },
+              [&](float a, size_t k, size_t j0, float *c, size_t n) { axpy(a, b + k * ldb + j0, c, n); },
+              C, M, N, K, ldc);
+}
+
+inline void gemm(WeightsView A, const float *B, float *C, size_t M, size_t N, size_t K,
+                 size_t lda = 0, size_t ldb = 0, size_t ldc = 0) {
+    if (!is_half(A.dtype)) {
+        gemm(A.f32(), B, C, M, N, K, false, false, false, lda, ldb, ldc);
+        return;
+    }
+    if (lda == 0) lda = K;
+    if (ldb == 0) ldb = N;
+    if (ldc == 0) ldc = N;
+    for (size_t i = 0; i < M; ++i) {
+        std::fill(C + i * ldc, C + i * ldc + N, 0.0f);
+    }
+    const simd::Kernels &kern = simd::kernels();
+    gemm_rows([&](size_t i, size_t k) { return A[i * lda + k]; },
+              [&](float a, size_t k, size_t j0, float *c, size_t n) { kern.axpy(a, B + k * ldb + j0, c, n); },
+              C, M, N, K, ldc);
+}
+
+// Reparte C[M, N] entre hilos en bloques disjuntos y llama a block(i0, rows, j0, cols):
+// - filas de C si hay al menos tantas filas como hilos
+// - columnas de C en otro caso (p. ej. GEMV con una sola fila)
+// Dentro de una region paralela activa se ejecuta en el hilo actual.
+template <typename Block>
+inline void parallel_blocks(size_t M, size_t N, Block block) {
+    const size_t threads = in_parallel_region() ? 1 : static_cast<size_t>(thread_count());
+
+    if (threads <= 1) {
+        block(0, M, 0, N);
+        return;
+    }
+
+    if (M >= threads) {
+        const size_t rows_per_task = (M + threads - 1) / threads;
+        #pragma omp parallel for
+        for (size_t t = 0; t < threads; ++t) {
+            size_t i0 = t * rows_per_task;
+            if (i0 >= M) continue;
+            block(i0, std::min(rows_per_task, M - i0), 0, N);
+        }
+        return;
+    }
+
+    // Bloques de columnas multiplos de 16 para no partir vectores SIMD
+    const size_t cols_per_task = ((N + threads - 1) / threads + 15) / 16 * 16;
+    #pragma omp parallel for
+    for (size_t t = 0; t < threads; ++t) {
+        size_t j0 = t * cols_per_task;
+        if (j0 >= N) continue;
+        block(0, M, j0, std::min(cols_per_task, N - j0));
+    }
+}
+
+// gemm repartido entre hilos (parallel_blocks); cada hilo escribe un bloque disjunto de C
+inline void parallel_gemm(const float *A, const float *B, float *C, size_t M, size_t N, size_t K,
+                          bool trans_a = false, bool trans_b = false, bool accumulate = false) {
+    const size_t lda = trans_a ? M : K;
+    const size_t ldb = trans_b ? K : N;
+    parallel_blocks(M, N, [&](size_t i0, size_t rows, size_t j0, size_t cols) {
+        const float *A_rows = trans_a ? A + i0 : A + i0 * lda;
+        const float *B_cols = trans_b ? B + j0 * ldb : B + j0;
+        gemm(A_rows, B_cols, C + i0 * N + j0, rows, cols, K, trans_a, trans_b, accumulate, lda, ldb, N);
+    });
+}
+
+// Versiones con los pesos en WeightsView (fp32 o 16 bits)
+inline void parallel_gemm(const float *A, WeightsView B, float *C, size_t M, size_t N, size_t K) {
+    parallel_blocks(M, N, [&](size_t i0, size_t rows, size_t j0, size_t cols) {
+        gemm(A + i0 * K, B.offset(j0), C + i0 * N + j0, rows, cols, K, K, N, N);
+    });
+}
+
+inline void parallel_gemm(WeightsView A, const float *B, float *C, size_t M, size_t N, size_t K) {
+    parallel_blocks(M, N, [&](size_t i0, size_t rows, size_t j0, size_t cols) {
+        gemm(A.offset(i0 * K), B + j0, C + i0 * N + j0, rows, cols, K, K, N, N);
+    });
+}
+
+
+// Funciones de activacion (Dense, Conv2D, capas de Activation.hpp)
+enum class Activation { LINEAR, RELU, SIGMOID, TANH, SOFTMAX };
+
+// Nombre en los archivos de modelo ("linear" para la identidad)
+inline const char* activation_name(Activation activation) {
+    switch (activation) {
+        case Activation::RELU: return "relu";
+        case Activation::SIGMOID: return "sigmoid";
+        case Activation::TANH: return "tanh";
+        case Activation::SOFTMAX: return "softmax";
+        default: return "linear";
+    }
+}
+
+// Cadena vacia o "linear": identidad
+inline Activation parse_activation(const std::string& name) {
+    if (name.empty() || name == "linear") return Activation::LINEAR;
+    if (name == "relu") return Activation::RELU;
+    if (name == "sigmoid") return Activation::SIGMOID;
+    if (name == "tanh") return Activation::TANH;
+    if (name == "softmax") return Activation::SOFTMAX;
+    throw std::invalid_argument("Activacion desconocida: '" + name + "' (linear, relu, sigmoid, tanh o softmax)");
+}
+
+// Activacion de una matriz [rows, cols] con los kernels SIMD (softmax fila por fila).
+// 'z' y 'a' pueden ser el mismo buffer
+inline void apply_activation(Activation activation, const float* z, float* a, size_t rows, size_t cols) {
+    const simd::Kernels& kern = simd::kernels();
+    const size_t total = rows * cols;
+    switch (activation) {
+        case Activation::SOFTMAX:
+            for (size_t n = 0; n < rows; ++n) {
+                kern.softmax(z + n * cols, a + n * cols, cols);
+            }
+            break;
+        case Activation::RELU: kern.relu(z, a, total); break;
+        case Activation::SIGMOID: kern.sigmoid(z, a, total); break;
+        case Activation::TANH: kern.tanh(z, a, total); break;
+        case Activation::LINEAR:
+            if (z != a) std::copy(z, z + total, a);
+            break;
+    }
+}
+
+// Gradiente respecto a la pre-activacion: g[i] *= f'(z[i]) (softmax y lineal no cambian g;
+// softmax solo se usa con cross-entropy, que ya llega simplificado)
+inline void apply_activation_grad(Activation activation, const float* z, float* g, size_t n) {
+    const simd::Kernels& kern = simd::kernels();
+    switch (activation) {
+        case Activation::RELU: kern.relu_grad(z, g, n); break;
+        case Activation::SIGMOID: kern.sigmoid_grad(z, g, n); break;
+        case Activation::TANH: kern.tanh_grad(z, g, n); break;
+        default: break;
+    }
+}
+
+// Rango [lo, hi) de posiciones de salida 'o' tales que 0 <= o * stride + offset < limit
+inline void valid_output_range(long offset, size_t stride, size_t limit, size_t out, size_t &lo, size_t &hi) {
+    long s = static_cast<long>(stride);
+    long first = (offset >= 0) ? 0 : (-offset + s - 1) / s;
+    long last = (static_cast<long>(limit) - 1 - offset); // ultima posicion valida * stride
+    long count = (last < 0) ? 0 : last / s + 1;
+    lo = static_cast<size_t>(std::min<long>(first, static_cast<long>(out)));
+    hi = static_cast<size_t>(std::max<long>(static_cast<long>(lo), std::min<long>(count, static_cast<long>(out))));
+}
+
+// Desenrolla los parches de una imagen [C, H, W] en una matriz de columnas
+// [C * kernel * kernel, out_h * out_w]; las posiciones de padding quedan en cero.
+// Los limites se calculan una vez por fila, sin comprobaciones en el bucle interno.
+// Con [row_begin, row_end) solo esas filas de salida: [C * kernel * kernel, filas * out_w]
+inline void im2col(const float *image, size_t channels, size_t height, size_t width,
+                   size_t kernel, size_t stride, size_t padding,
+                   size_t out_h, size_t out_w, float *col,
+                   size_t row_begin = 0, size_t row_end = SIZE_MAX) {
+    row_end = std::min(row_end, out_h);
+    const size_t columns = (row_end - row_begin) * out_w;
+    for (size_t c = 0; c < channels; ++c) {
+        const float *plane = image + c * height * width;
+        for (size_t kh = 0; kh < kernel; ++kh) {
+            size_t h_lo, h_hi;
+            valid_output_range(static_cast<long>(kh) - static_cast<long>(padding), stride, height, out_h, h_lo, h_hi);
+            for (size_t kw = 0; kw < kernel; ++kw) {
+                size_t w_lo, w_hi;
+                valid_output_range(static_cast<long>(kw) - static_cast<long>(padding), stride, width, out_w, w_lo, w_hi);
+                float *row = col + ((c * kernel + kh) * kernel + kw) * columns;
+
+                for (size_t oh = row_begin; oh < row_end; ++oh) {
+                    float *dst = row + (oh - row_begin) * out_w;
+                    if (oh < h_lo || oh >= h_hi) {
+                        std::fill(dst, dst + out_w, 0.0f);
+                        continue;
+                    }
+                    // Dentro de [w_lo, w_hi) el indice nunca sale de la imagen
+                    const size_t base = (oh * stride + kh - padding) * width + kw - padding;
+                    std::fill(dst, dst + w_lo, 0.0f);
+                    for (size_t ow = w_lo; ow < w_hi; ++ow) {
+                        dst[ow] = plane[base + ow * stride];
+                    }
+                    std::fill(dst + w_hi, dst + out_w, 0.0f);
+                }
+            }
+        }
+    }
+}
+
+// Operacion inversa de im2col: acumula cada columna en su posicion de la imagen [C, H, W]
+inline void col2im(const float *col, size_t channels, size_t height, size_t width,
+                   size_t kernel, size_t stride, size_t padding,
+                   size_t out_h, size_t out_w, float *image) {
+    for (size_t c = 0; c < channels; ++c) {
+        float *plane = image + c * height * width;
+        for (size_t kh = 0; kh < kernel; ++kh) {
+            size_t h_lo, h_hi;
+            valid_output_range(static_cast<long>(kh) - static_cast<long>(padding), stride, height, out_h, h_lo, h_hi);
+            for (size_t kw = 0; kw < kernel; ++kw) {
+                size_t w_lo, w_hi;
+                valid_output_range(static_cast<long>(kw) - static_cast<long>(padding), stride, width, out_w, w_lo, w_hi);
+                const float *row = col + ((c * kernel + kh) * kernel + kw) * out_h * out_w;
+
+                for (size_t oh = h_lo; oh < h_hi; ++oh) {
+                    const float *src = row + oh * out_w;
+                    const size_t base = (oh * stride + kh - padding) * width + kw - padding;
+                    for (size_t ow = w_lo; ow < w_hi; ++ow) {
+                        plane[base + ow * stride] += src[ow];
+                    }
+                }
+            }
+        }
+    }
+}
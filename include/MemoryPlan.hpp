@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Uso de un buffer de la arena; determina su tiempo de vida dentro de un paso
+enum class BufferUse {
+    OUTPUT,          // Salida del forward: la lee la capa siguiente (y su backward)
+    SAVED,           // Se guarda en el forward para el backward de la misma capa
+    FORWARD_SCRATCH, // Temporal del forward de la capa
+    GRAD_INPUT,      // Salida del backward: la lee el backward de la capa anterior
+    BACKWARD_SCRATCH // Temporal del backward de la capa
+};
+
+// Buffer que una capa pide a la arena ('slot' lo identifica dentro de la capa)
+struct BufferRequest {
+    int slot;
+    size_t count; // Floats
+    BufferUse use;
+};
+
+// Identidad de un buffer: quien lo pide y cual de sus buffers es
+struct BufferKey {
+    const void *owner;
+    int slot;
+
+    bool operator==(const BufferKey &other) const { return owner == other.owner && slot == other.slot; }
+};
+
+struct BufferKeyHash {
+    size_t operator()(const BufferKey &key) const {
+        return std::hash<const void *>()(key.owner) ^ (static_cast<size_t>(key.slot) * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
+// Buffer con su intervalo de vida [first, last] (inclusive) en el cronograma de un paso
+struct BufferLifetime {
+    BufferKey key;
+    size_t count;
+    size_t first, last;
+};
+
+// Plan de memoria: offset fijo de cada buffer dentro de la arena. Buffers cuyos
+// intervalos de vida no se solapan comparten memoria.
+class MemoryPlan {
+public:
+    struct Region {
+        size_t offset; // Floats desde el inicio de la arena
+        size_t size;   // Floats reservados (alineados a simd::ALIGNMENT)
+    };
+
+    size_t size = 0;     // Floats que ocupa el plan (pico de memoria)
+    size_t unshared = 0; // Floats que harian falta sin compartir memoria
+
+    // Asignacion greedy por tamaño: cada buffer (del mayor al menor) ocupa el primer
+    // hueco que no pise a un buffer ya ubicado con un intervalo de vida solapado
+    static MemoryPlan build(vector<BufferLifetime> buffers) {
+        std::stable_sort(buffers.begin(), buffers.end(),
+                         [](const BufferLifetime &a, const BufferLifetime &b) { return a.count > b.count; });
+
+        struct Placed {
+            size_t first, last, offset, size;
+        };
+        MemoryPlan plan;
+        vector<Placed> placed;
+        vector<const Placed *> conflicts;
+
+        for (const auto &buffer : buffers) {
+            const size_t size = simd::align_floats(std::max<size_t>(buffer.count, 1));
+            plan.unshared += size;
+
+            conflicts.clear();
+            for (const auto &p : placed) {
+                if (p.first <= buffer.last && buffer.first <= p.last) {
+                    conflicts.push_back(&p);
+                }
+            }
+            std::sort(conflicts.begin(), conflicts.end(),
+                      [](const Placed *a, const Placed *b) { return a->offset < b->offset; });
+
+            size_t offset = 0;
+            for (const Placed *p : conflicts) {
+                if (offset + size <= p->offset) break;
+                offset = std::max(offset, p->offset + p->size);
+            }
+
+            placed.push_back({buffer.first, buffer.last, offset, size});
+            plan.regions[buffer.key] = {offset, size};
+            plan.size = std::max(plan.size, offset + size);
+        }
+        return plan;
+    }
+
+    // Region asignada a un buffer (nullptr si no esta en el plan)
+    const Region *find(const BufferKey &key) const {
+        auto it = regions.find(key);
+        return it == regions.end() ? nullptr : &it->second;
+    }
+
+    bool empty() const { return regions.empty(); }
+
+private:
+    unordered_map<BufferKey, Region, BufferKeyHash> regions;
+};
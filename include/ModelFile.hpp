@@ -0,0 +1,555 @@
+#pragma once
+
+#include "Activation.hpp"
+#include "Conv2D.hpp"
+#include "Dense.hpp"
+#include "Dropout.hpp"
+#include "Flatten.hpp"
+#include "Layer.hpp"
+#include "Pool2D.hpp"
+#include "Quantize.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Formato del archivo de modelo (version 1, little-endian):
+//   [FileHeader: 64 bytes]
+//   [grafo: texto]          loss, forma de entrada, optimizador y una linea por capa
+//   [TensorRecord x N]      tabla de tensores (64 bytes cada uno)
+//   [payloads]              datos de cada tensor, alineados a 64 bytes
+// Los tensores son los parametros de cada capa (en el orden de collect_parameters), sus
+// buffers no entrenables (collect_buffers) y, opcionalmente, el estado del optimizador. Cada payload lleva su CRC-32 y el grafo y
+// la tabla uno comun en la cabecera. Los archivos sin cabecera son del formato anterior
+// (solo los floats de Dense y Conv2D en orden).
+namespace model_file {
+
+constexpr char MAGIC[8] = {'C', 'N', 'N', 'M', 'O', 'D', 'E', 'L'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t ALIGNMENT = 64;
+
+enum Flags : uint32_t {
+    HAS_OPTIMIZER = 1u << 0 // Incluye momentos y pasos del optimizador
+};
+
+enum class TensorKind : uint32_t {
+    PARAMETER = 0,       // Parametro 'index' de la capa 'layer'
+    OPTIMIZER_STATE = 1, // Slot 'slot' del optimizador para ese parametro
+    BUFFER = 2           // Buffer 'index' de la capa (Layer::collect_buffers)
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t graph_offset;
+    uint64_t graph_bytes;
+    uint64_t table_offset;
+    uint64_t tensor_count;
+    uint32_t metadata_crc; // CRC-32 del grafo y de la tabla
+    uint32_t reserved[3];
+};
+
+struct TensorRecord {
+    uint32_t kind;   // TensorKind
+    uint32_t layer;
+    uint32_t index;
+    uint32_t slot;
+    uint32_t dtype;  // DType (Tensor.hpp)
+    uint32_t rank;
+    uint32_t dims[4];
+    uint32_t crc;    // CRC-32 del payload
+    uint32_t reserved;
+    uint64_t offset; // Desde el inicio del archivo (multiplo de ALIGNMENT)
+    uint64_t bytes;
+};
+
+static_assert(sizeof(FileHeader) == 64, "FileHeader debe ocupar 64 bytes");
+static_assert(sizeof(TensorRecord) == 64, "TensorRecord debe ocupar 64 bytes");
+
+// Los archivos de este formato empiezan con MAGIC (los del formato anterior no)
+inline bool has_magic(const unsigned char *data, size_t size) {
+    return size >= sizeof(MAGIC) && memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+inline bool is_model_file(const string &path) {
+    ifstream file(path, ios::binary);
+    unsigned char magic[sizeof(MAGIC)];
+    return file.read(reinterpret_cast<char *>(magic), sizeof(magic)) && has_magic(magic, sizeof(magic));
+}
+
+inline uint64_t align(uint64_t offset) { return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+// CRC-32 (polinomio 0xEDB88320, el de zlib); 'crc' permite encadenar bloques
+inline uint32_t crc32(const void *data, size_t bytes, uint32_t crc = 0) {
+    static const array<uint32_t, 256> table = [] {
+        array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < bytes; ++i) {
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// Configuracion de una capa sin el tipo de los pesos: al cargar sobre una red ya armada
+// se compara la arquitectura y los pesos se convierten al tipo de sus capas
+inline string without_precision(const string &config) {
+    const size_t space = config.rfind(' ');
+    if (space != string::npos && (config.compare(space + 1, string::npos, "bf16") == 0 ||
+                                  config.compare(space + 1, string::npos, "fp16") == 0)) {
+        return config.substr(0, space);
+    }
+    return config;
+}
+
+// Activacion por nombre sin excepcion (false si 'name' no es una)
+inline bool read_activation(const string &name, Activation &activation) {
+    for (Activation a : {Activation::LINEAR, Activation::RELU, Activation::SIGMOID, Activation::TANH,
+                         Activation::SOFTMAX}) {
+        if (name == activation_name(a)) {
+            activation = a;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Crea una capa a partir de su linea de configuracion (Layer::save).
+// Con 'allocate' = false los parametros no se reservan ni inicializan (para map_parameters)
+inline unique_ptr<Layer> make_layer(const string &config, bool allocate = true) {
+    istringstream in(config);
+    string type;
+    in >> type;
+
+    unique_ptr<Layer> layer;
+    Activation activation = Activation::LINEAR;
+    if (type == "Dense") {
+        size_t input_dim, output_dim;
+        string name;
+        float lambda;
+        in >> input_dim >> output_dim >> name >> lambda;
+        if (in && read_activation(name, activation)) {
+            layer = make_unique<Dense>(input_dim, output_dim, activation, lambda, allocate);
+        }
+    } else if (type == "Conv2D") {
+        size_t in_channels, out_channels, kernel, stride, padding;
+        in >> in_channels >> out_channels >> kernel >> stride >> padding;
+        if (in) {
+            // Activacion opcional (antes del tipo de los pesos)
+            string name;
+            const streampos fields_end = in.tellg();
+            if (!(in >> name) || name == "bf16" || name == "fp16") {
+                name = "linear";
+                in.clear();
+                in.seekg(fields_end);
+            }
+            if (read_activation(name, activation) && activation != Activation::SOFTMAX) {
+                layer = make_unique<Conv2D>(in_channels, out_channels, kernel, stride, padding, activation, allocate);
+            }
+        }
+    } else if (type == "Pooling2D") {
+        size_t size, stride;
+        string name;
+        in >> size >> stride >> name;
+        const PoolingType pooling = name == "MIN" ? PoolingType::MIN
+                                  : name == "AVERAGE" ? PoolingType::AVERAGE : PoolingType::MAX;
+        if (in && (name == "MAX" || name == "MIN" || name == "AVERAGE")) {
+            layer = make_unique<Pooling2D>(size, stride, pooling);
+        }
+    } else if (type == "QuantizedDense") {
+        size_t input_dim, output_dim;
+        string name;
+        ActivationQuant quant;
+        in >> input_dim >> output_dim >> name >> quant.scale >> quant.zero_point;
+        if (in && read_activation(name, activation)) {
+            layer = make_unique<QuantizedDense>(input_dim, output_dim, activation, quant);
+        }
+    } else if (type == "QuantizedConv2D") {
+        size_t in_channels, out_channels, kernel, stride, padding;
+        ActivationQuant quant;
+        in >> in_channels >> out_channels >> kernel >> stride >> padding >> quant.scale >> quant.zero_point;
+        if (in) {
+            string name; // Opcional (ultimo campo)
+            if (!(in >> name)) name = "linear";
+            if (read_activation(name, activation) && activation != Activation::SOFTMAX) {
+                layer = make_unique<QuantizedConv2D>(in_channels, out_channels, kernel, stride, padding, activation, quant);
+            }
+        }
+    } else if (type == "ReLU") {
+        layer = make_unique<ReLU>();
+    } else if (type == "Sigmoid") {
+        layer = make_unique<Sigmoid>();
+    } else if (type == "Tanh") {
+        layer = make_unique<Tanh>();
+    } else if (type == "Softmax") {
+        layer = make_unique<Softmax>();
+    } else if (type == "Flatten") {
+        layer = make_unique<Flatten>();
+    } else if (type == "Dropout") {
+        istringstream line(config);
+        auto dropout = make_unique<Dropout>(0.5f);
+        dropout->load(line);
+        layer = std::move(dropout);
+    }
+
+    // Tipo de los pesos de Dense y Conv2D (ultimo campo, solo si no es fp32)
+    string precision;
+    if (layer && (type == "Dense" || type == "Conv2D") && in >> precision) {
+        if (precision == "bf16" || precision == "fp16") {
+            layer->set_precision(parse_dtype(precision), false);
+        } else {
+            layer.reset();
+        }
+    }
+
+    if (!layer) {
+        throw std::runtime_error("Modelo: configuracion de capa invalida: '" + config + "'");
+    }
+    return layer;
+}
+
+// Grafo del modelo: todo lo que no son tensores
+struct Graph {
+    string loss;
+    Shape input_shape;    // Forma planificada (vacia si la red no se planifico)
+    string optimizer;     // Vacio si el archivo no trae el estado del optimizador
+    float learning_rate = 0.0f, beta1 = 0.0f, beta2 = 0.0f;
+    int steps = 0;
+    vector<string> layers; // Configuracion de cada capa (Layer::save); solo al leer
+};
+
+// Escribe el modelo: 'graph' (sin las capas, que salen de 'layers') y los parametros de
+// cada capa ('layer_parameters[l]' es el indice en 'parameters' del primero de la capa l,
+// mas el total al final). Con 'optimizer' se guarda tambien su estado (punto de control)
+inline void write_model(ostream &out, const Graph &graph, const vector<unique_ptr<Layer>> &layers,
+                        const vector<Parameter> &parameters, const vector<size_t> &layer_parameters,
+                        const Optimizer *optimizer) {
+    const bool with_optimizer = optimizer != nullptr;
+
+    // Grafo: loss, forma de entrada, optimizador y una linea por capa
+    ostringstream graph_out;
+    graph_out << std::setprecision(9) << "loss " << graph.loss << "\n";
+    if (!graph.input_shape.empty()) {
+        graph_out << "input";
+        for (size_t dim : graph.input_shape) graph_out << " " << dim;
+        graph_out << "\n";
+    }
+    if (with_optimizer) {
+        graph_out << "optimizer " << graph.optimizer << " " << graph.learning_rate << " " << graph.beta1 << " "
+                  << graph.beta2 << " " << optimizer->steps() << "\n";
+    }
+    graph_out << "layers " << layers.size() << "\n";
+    for (const auto &layer : layers) {
+        layer->save(graph_out);
+    }
+    const string graph_text = graph_out.str();
+
+    // Tabla de tensores: parametros de cada capa y (opcional) estado del optimizador
+    vector<TensorRecord> table;
+    vector<const void *> payloads;
+    auto add_tensor = [&](TensorKind kind, size_t layer, size_t index, size_t slot, DType dtype, const Shape &shape,
+                          const void *data, size_t bytes) {
+        if (shape.size() > 4) {
+            throw runtime_error("Modelo: tensores de mas de 4 dimensiones no soportados");
+        }
+        TensorRecord record{};
+        record.kind = static_cast<uint32_t>(kind);
+        record.layer = static_cast<uint32_t>(layer);
+        record.index = static_cast<uint32_t>(index);
+        record.slot = static_cast<uint32_t>(slot);
+        record.dtype = static_cast<uint32_t>(dtype);
+        record.rank = static_cast<uint32_t>(shape.size());
+        for (size_t d = 0; d < shape.size(); ++d) record.dims[d] = static_cast<uint32_t>(shape[d]);
+        record.bytes = bytes;
+        record.crc = crc32(data, record.bytes);
+        table.push_back(record);
+        payloads.push_back(data);
+    };
+    for (size_t l = 0; l < layers.size(); ++l) {
+        for (size_t p = layer_parameters[l]; p < layer_parameters[l + 1]; ++p) {
+            const Tensor &value = *parameters[p].value;
+            const size_t bytes = value.shape.numel() * sizeof(float);
+            // Pesos en 16 bits: asi se guardan, salvo en un punto de control (con optimizador),
+            // que guarda la copia maestra fp32 para reanudar exactamente
+            if (is_half(value.dtype) && !(with_optimizer && value.has_master())) {
+                add_tensor(TensorKind::PARAMETER, l, p - layer_parameters[l], 0, value.dtype, value.shape,
+                           value.half.data(), value.half.size() * sizeof(uint16_t));
+            } else {
+                add_tensor(TensorKind::PARAMETER, l, p - layer_parameters[l], 0, DType::FLOAT32, value.shape,
+                           value.data.data(), bytes);
+            }
+            if (with_optimizer) {
+                for (size_t slot = 0; slot < optimizer->slots(); ++slot) {
+                    add_tensor(TensorKind::OPTIMIZER_STATE, l, p - layer_parameters[l], slot, DType::FLOAT32,
+                               value.shape, optimizer->slot_data(p, slot), bytes);
+                }
+            }
+        }
+        vector<LayerBuffer> buffers;
+        layers[l]->collect_buffers(buffers);
+        for (size_t b = 0; b < buffers.size(); ++b) {
+            add_tensor(TensorKind::BUFFER, l, b, 0, buffers[b].dtype, buffers[b].shape, buffers[b].data,
+                       buffers[b].bytes);
+        }
+    }
+
+    // Posiciones: grafo tras la cabecera, luego la tabla y los payloads alineados
+    FileHeader header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.flags = with_optimizer ? static_cast<uint32_t>(HAS_OPTIMIZER) : 0u;
+    header.graph_offset = sizeof(FileHeader);
+    header.graph_bytes = graph_text.size();
+    header.table_offset = align(header.graph_offset + header.graph_bytes);
+    header.tensor_count = table.size();
+    uint64_t offset = align(header.table_offset + table.size() * sizeof(TensorRecord));
+    for (TensorRecord &record : table) {
+        record.offset = offset;
+        offset = align(offset + record.bytes);
+    }
+    header.metadata_crc = crc32(graph_text.data(), graph_text.size());
+    header.metadata_crc = crc32(table.data(), table.size() * sizeof(TensorRecord), header.metadata_crc);
+
+    uint64_t written = 0;
+    auto write = [&](const void *data, uint64_t bytes) {
+        out.write(static_cast<const char *>(data), bytes);
+        written += bytes;
+    };
+    auto pad_to = [&](uint64_t position) {
+        static const char zeros[ALIGNMENT] = {};
+        write(zeros, position - written);
+    };
+    write(&header, sizeof(header));
+    write(graph_text.data(), graph_text.size());
+    pad_to(header.table_offset);
+    write(table.data(), table.size() * sizeof(TensorRecord));
+    for (size_t t = 0; t < table.size(); ++t) {
+        pad_to(table[t].offset);
+        write(payloads[t], table[t].bytes);
+    }
+}
+
+// Cabecera de un archivo de este formato (ya verificado el numero magico): comprueba la
+// version, que el grafo y la tabla esten dentro del archivo y su CRC
+inline FileHeader read_header(const unsigned char *data, size_t size) {
+    if (size < sizeof(FileHeader)) {
+        throw runtime_error("Modelo: archivo truncado (cabecera incompleta)");
+    }
+    FileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.version != VERSION) {
+        throw runtime_error("Modelo: version " + to_string(header.version) + " no soportada");
+    }
+    const uint64_t table_bytes = header.tensor_count * sizeof(TensorRecord);
+    if (header.graph_offset > size || header.graph_bytes > size - header.graph_offset ||
+        header.table_offset > size || header.tensor_count > size / sizeof(TensorRecord) ||
+        table_bytes > size - header.table_offset) {
+        throw runtime_error("Modelo: archivo truncado (grafo o tabla fuera del archivo)");
+    }
+    uint32_t crc = crc32(data + header.graph_offset, header.graph_bytes);
+    crc = crc32(data + header.table_offset, table_bytes, crc);
+    if (crc != header.metadata_crc) {
+        throw runtime_error("Modelo: grafo o tabla de tensores corruptos (CRC distinto)");
+    }
+    return header;
+}
+
+inline Graph read_graph(const unsigned char *data, const FileHeader &header) {
+    istringstream text(string(reinterpret_cast<const char *>(data + header.graph_offset), header.graph_bytes));
+    Graph graph;
+    string line;
+    while (getline(text, line)) {
+        istringstream fields(line);
+        string key;
+        fields >> key;
+        if (key == "loss") {
+            fields >> graph.loss;
+        } else if (key == "input") {
+            size_t dim;
+            while (fields >> dim) graph.input_shape.push_back(dim);
+        } else if (key == "optimizer") {
+            fields >> graph.optimizer >> graph.learning_rate >> graph.beta1 >> graph.beta2 >> graph.steps;
+        } else if (key == "layers") {
+            size_t count = 0;
+            fields >> count;
+            for (size_t i = 0; i < count && getline(text, line); ++i) graph.layers.push_back(line);
+            if (graph.layers.size() != count) {
+                throw runtime_error("Modelo: faltan capas en el grafo");
+            }
+        }
+    }
+    return graph;
+}
+
+// Compara las capas de una red ya armada con las del archivo (sin el tipo de los pesos).
+// Dropout toma la tasa y el estado del generador del archivo
+inline void match_layers(const vector<unique_ptr<Layer>> &layers, const vector<string> &configs) {
+    if (layers.size() != configs.size()) {
+        throw runtime_error("Modelo: el archivo tiene " + to_string(configs.size()) + " capas y la red " +
+                            to_string(layers.size()));
+    }
+    for (size_t i = 0; i < layers.size(); ++i) {
+        ostringstream current;
+        layers[i]->save(current);
+        string expected = current.str();
+        expected.pop_back(); // '\n'
+        if (auto dropout_layer = dynamic_cast<Dropout *>(layers[i].get())) {
+            istringstream config(configs[i]);
+            dropout_layer->load(config);
+        } else if (without_precision(expected) != without_precision(configs[i])) {
+            throw runtime_error("Modelo: la capa " + to_string(i) + " es '" + expected + "' y en el archivo '" +
+                                configs[i] + "'");
+        }
+    }
+}
+
+// Lee los tensores del archivo en las capas. Con 'map' las capas apuntan a 'data'
+// (map_parameters) en vez de copiar los pesos y el estado del optimizador se ignora;
+// si no, va a 'optimizer' (nulo si el archivo no lo trae). Los CRC de los payloads solo
+// se comprueban con 'verify_checksums'
+inline void read_tensors(const unsigned char *data, size_t size, const FileHeader &header,
+                         const vector<unique_ptr<Layer>> &layers, const vector<Parameter> &parameters,
+                         const vector<size_t> &layer_parameters, Optimizer *optimizer, bool map,
+                         bool verify_checksums) {
+    vector<bool> loaded(parameters.size(), false);
+    vector<const void *> mapped(parameters.size(), nullptr);
+    vector<vector<LayerBuffer>> buffers(layers.size());
+    vector<vector<bool>> buffer_loaded(layers.size());
+    for (size_t l = 0; l < layers.size(); ++l) {
+        layers[l]->collect_buffers(buffers[l]);
+        buffer_loaded[l].assign(buffers[l].size(), false);
+    }
+    for (uint64_t t = 0; t < header.tensor_count; ++t) {
+        TensorRecord record;
+        memcpy(&record, data + header.table_offset + t * sizeof(TensorRecord), sizeof(record));
+        if (record.layer >= layers.size()) {
+            throw runtime_error("Modelo: tensor de una capa que no existe");
+        }
+        if (record.offset % ALIGNMENT != 0 || record.offset > size || record.bytes > size - record.offset) {
+            throw runtime_error("Modelo: archivo truncado (tensor fuera del archivo)");
+        }
+        if (verify_checksums && crc32(data + record.offset, record.bytes) != record.crc) {
+            throw runtime_error("Modelo: datos corruptos en la capa " + to_string(record.layer) + " (CRC distinto)");
+        }
+        Shape shape;
+        for (uint32_t d = 0; d < std::min<uint32_t>(record.rank, 4); ++d) shape.push_back(record.dims[d]);
+        auto mismatch = [&](const char *what, const Shape &expected) {
+            ostringstream msg;
+            msg << "Modelo: el " << what << " " << record.index << " de la capa " << record.layer << " es "
+                << expected << " y en el archivo " << shape;
+            return runtime_error(msg.str());
+        };
+
+        // Buffers no entrenables de la capa (p. ej. pesos int8)
+        if (record.kind == static_cast<uint32_t>(TensorKind::BUFFER)) {
+            if (record.index >= buffers[record.layer].size()) {
+                throw runtime_error("Modelo: buffer de la capa " + to_string(record.layer) + " que no existe");
+            }
+            LayerBuffer &buffer = buffers[record.layer][record.index];
+            if (record.dtype != static_cast<uint32_t>(buffer.dtype) || shape != buffer.shape ||
+                record.bytes != buffer.bytes) {
+                throw mismatch("buffer", buffer.shape);
+            }
+            memcpy(buffer.data, data + record.offset, record.bytes);
+            buffer_loaded[record.layer][record.index] = true;
+            continue;
+        }
+
+        if (record.index >= layer_parameters[record.layer + 1] - layer_parameters[record.layer]) {
+            throw runtime_error("Modelo: tensor de un parametro que no existe");
+        }
+        const size_t param = layer_parameters[record.layer] + record.index;
+        Tensor &value = *parameters[param].value;
+        const DType dtype = static_cast<DType>(record.dtype);
+        const bool is_parameter = record.kind == static_cast<uint32_t>(TensorKind::PARAMETER);
+        if (!(dtype == DType::FLOAT32 || (is_parameter && is_half(dtype))) || shape != value.shape ||
+            record.bytes != value.shape.numel() * dtype_size(dtype)) {
+            throw mismatch("parametro", value.shape);
+        }
+
+        if (is_parameter) {
+            loaded[param] = true;
+            if (map) {
+                // Sin copia: la capa usa el tipo que tiene el archivo
+                value.set_dtype(dtype);
+                mapped[param] = data + record.offset; // Alineado a 64 bytes
+            } else {
+                value.assign(data + record.offset, dtype); // Convierte al tipo de la capa
+            }
+        } else if (record.kind == static_cast<uint32_t>(TensorKind::OPTIMIZER_STATE) &&
+                   (map || (optimizer && record.slot < optimizer->slots()))) {
+            if (!map) { // Mapeado: solo inferencia
+                memcpy(optimizer->slot_data(param, record.slot), data + record.offset, record.bytes);
+            }
+        } else {
+            throw runtime_error("Modelo: tensor de tipo desconocido");
+        }
+    }
+    if (std::find(loaded.begin(), loaded.end(), false) != loaded.end()) {
+        throw runtime_error("Modelo: faltan parametros en el archivo");
+    }
+    for (const auto &flags : buffer_loaded) {
+        if (std::find(flags.begin(), flags.end(), false) != flags.end()) {
+            throw runtime_error("Modelo: faltan buffers en el archivo");
+        }
+    }
+    if (map) {
+        for (size_t l = 0; l < layers.size(); ++l) {
+            layers[l]->map_parameters(vector<const void *>(mapped.begin() + layer_parameters[l],
+                                                            mapped.begin() + layer_parameters[l + 1]));
+        }
+    }
+}
+
+// Formato anterior: floats de Dense (pesos, bias) y Conv2D (kernels, bias) en orden
+inline void read_legacy_model(const unsigned char *data, size_t size, const vector<unique_ptr<Layer>> &layers) {
+    size_t expected = 0;
+    for (const auto &layer : layers) {
+        if (auto dense_layer = dynamic_cast<Dense *>(layer.get())) {
+            expected += dense_layer->weights.shape.numel() + dense_layer->bias.shape.numel();
+        } else if (auto conv_layer = dynamic_cast<Conv2D *>(layer.get())) {
+            expected += conv_layer->kernels.shape.numel() + conv_layer->bias.shape.numel();
+        }
+    }
+    if (size != expected * sizeof(float)) {
+        throw runtime_error("Modelo: el archivo (formato sin cabecera) tiene " + to_string(size) +
+                            " bytes y la arquitectura espera " + to_string(expected * sizeof(float)));
+    }
+
+    // Los floats se convierten al tipo de cada tensor (pesos en 16 bits y su copia maestra)
+    auto read = [&](Tensor &tensor) {
+        tensor.assign(data, DType::FLOAT32);
+        data += tensor.shape.numel() * sizeof(float);
+    };
+    for (const auto &layer : layers) {
+        if (auto dense_layer = dynamic_cast<Dense *>(layer.get())) {
+            read(dense_layer->weights);
+            read(dense_layer->bias);
+        } else if (auto conv_layer = dynamic_cast<Conv2D *>(layer.get())) {
+            read(conv_layer->kernels);
+            read(conv_layer->bias);
+        }
+    }
+}
+
+} // namespace model_file
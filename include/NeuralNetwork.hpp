@@ -1,21 +1,63 @@
 #pragma once
+#include "DataLoader.hpp"
+#include "Dataset.hpp"
 #include "Dense.hpp"
+#include "Distributed.hpp"
 #include "Dropout.hpp"
+#include "Fusion.hpp"
 #include "Layer.hpp"
+#include "MappedFile.hpp"
+#include "MemoryPlan.hpp"
+#include "ModelFile.hpp"
 #include "Optimizer.hpp"
+#include "Threads.hpp"
 #include "Utils.hpp"
+#include "Workspace.hpp"
 
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <vector>
 
 class NeuralNetwork {
 private:
   vector<unique_ptr<Layer>> layers; // Vector de capas de la red
+  // Secuencia de inferencia (Fusion.hpp): capas de la red o pasos fusionados de 'fused_layers'.
+  // Se rearma cada vez que cambian las capas
+  vector<const Layer *> inference_layers;
+  vector<unique_ptr<Layer>> fused_layers;
+  bool layer_fusion = true;
   unique_ptr<Optimizer> optimizer;  // Puntero al optimizador
+  // Argumentos de compile() para el optimizador (se guardan con el modelo)
+  struct {
+    string name;
+    float learning_rate, beta1, beta2;
+  } optimizer_config;
+  shared_ptr<const MappedFile> mapped_model; // Archivo proyectado con map_model (pesos de solo lectura)
   string error_function;            // funcion para calculo del error
+  DataLoader::Augmentation augmentation; // Aumentacion de datos opcional (hilo del cargador)
+  unsigned shuffle_seed = 42;            // Semilla base del orden de los batches en fit()
+  // Arena compartida por las capas: activaciones y gradientes de un paso. Se dimensiona
+  // en el primer paso y luego se reutiliza sin reservar memoria (direccion estable)
+  unique_ptr<Workspace> workspace = make_unique<Workspace>();
+  // Planes de memoria para la forma de entrada planificada (vacia = sin plan)
+  Shape planned_input;
+  MemoryPlan training_plan;  // forward + perdida + backward
+  MemoryPlan inference_plan; // solo forward
+  bool training_mode = true;         // Modo actual de las capas (Dropout empieza entrenando)
+  size_t inference_batch = 256;      // Filas por tramo en predict()
+  // Entrenamiento data-parallel: cada batch se parte en 'shards' partes; la parte 0 la
+  // procesa esta red y cada una de las demas una replica con capas (caches y gradientes)
+  // y arena propias
+  size_t shards = 1;
+  vector<unique_ptr<NeuralNetwork>> replicas;
+  vector<Parameter> parameters;    // Parametros de las capas (replicas y reduccion entre procesos)
+  vector<size_t> layer_parameters; // Indice en 'parameters' del primero de cada capa (+ el total)
+  RingCommunicator *communicator = nullptr; // Entrenamiento distribuido (no es propiedad de la red)
+  vector<pair<float, float>> part_metrics; // Perdida y aciertos de cada parte del batch
 public:
   NeuralNetwork(string error_function = "cross-entropy") { this->error_function = error_function; }
 
@@ -36,63 +78,151 @@ public:
     } else {
       throw runtime_error("Optimizador no soportado: " + optimizer_name);
     }
+    optimizer_config = {optimizer_name, learning_rate, beta1, beta2};
+    bind_optimizer();
+    build_inference_graph();
 
     if (loss_function != "mse" && loss_function != "cross-entropy") {
       throw runtime_error("Funcion de perdida no soportada: " + loss_function);
     }
   }
 
+  // Igual que compile() y ademas valida las formas para un batch de entrada
+  // 'input_shape' (p. ej. {64, 1, 28, 28}) y prepara el plan de memoria
+  void compile(const Shape &input_shape, const string &loss_function = "cross-entropy", const string &optimizer_name = "sgd",
+               float learning_rate = 0.001, float beta1 = 0.9f, float beta2 = 0.999f) {
+    compile(loss_function, optimizer_name, learning_rate, beta1, beta2);
+    plan_memory(input_shape);
+  }
+
+  // Propaga la forma de entrada por todas las capas: shapes[i] es la entrada de la
+  // capa i y shapes.back() la salida de la red. Lanza invalid_argument indicando la
+  // capa si alguna forma no es compatible
+  vector<Shape> infer_shapes(const Shape &input_shape) const {
+    vector<Shape> shapes{input_shape};
+    for (size_t i = 0; i < layers.size(); ++i) {
+      try {
+        shapes.push_back(layers[i]->output_shape(shapes.back()));
+      } catch (const std::invalid_argument &e) {
+        throw std::invalid_argument("Capa " + to_string(i) + ": " + e.what());
+      }
+    }
+    return shapes;
+  }
+
+  // Plan de memoria por analisis de vida para batches de forma 'input_shape'.
+  // Cronograma de un paso con L capas:
+  //   forward de la capa i -> i,   perdida -> L,   backward de la capa i -> 2L - i
+  // Cada buffer vive desde que se crea hasta su ultimo lector; los que no coinciden
+  // en el tiempo comparten memoria. Batches mas grandes que el planificado siguen
+  // funcionando (la arena reparte aparte lo que no cabe en el plan)
+  void plan_memory(const Shape &input_shape) {
+    vector<const Layer *> steps;
+    for (const auto &layer : layers) steps.push_back(layer.get());
+    training_plan = MemoryPlan::build(buffer_lifetimes(steps, infer_shapes(input_shape), true));
+
+    // La inferencia recorre la secuencia fusionada (sus formas ya quedaron validadas)
+    vector<Shape> shapes{input_shape};
+    for (const Layer *step : inference_layers) shapes.push_back(step->output_shape(shapes.back()));
+    inference_plan = MemoryPlan::build(buffer_lifetimes(inference_layers, shapes, false));
+    workspace->reserve_planned(std::max(training_plan.size, inference_plan.size));
+    planned_input = input_shape;
+  }
+
+  const MemoryPlan &memory_plan(bool training = true) const { return training ? training_plan : inference_plan; }
+
+  // Aumentacion aplicada a cada batch de entrenamiento en el hilo del cargador
+  void set_augmentation(DataLoader::Augmentation augment) { augmentation = std::move(augment); }
+
+  // Semilla del orden de los batches (y de la aumentacion). Cada epoca usa una derivada de
+  // esta y del paso del optimizador, asi un fit() tras load_model sigue con el mismo orden
+  void set_shuffle_seed(unsigned seed) { shuffle_seed = seed; }
+
   void add_layer(unique_ptr<Layer> layer) { // Agrega capa a la red
+    layer->set_workspace(workspace.get());
+    layer->set_training(training_mode);
     layers.push_back(std::move(layer));     // Inserta usando move semantics
+    planned_input.clear();                  // El plan de memoria ya no corresponde a la red
+    build_inference_graph();
+    replicas.clear();
+    parameters.clear();
+    layer_parameters.clear();
+    if (optimizer) {
+      bind_optimizer(); // Nuevos parametros: se reinicia el estado del optimizador
+    }
   }
 
-  // Calcula error cuadratico medio
-  float mse(const Tensor &y_pred, const Tensor &y_true) const {
+  // Registra en el optimizador los parametros de todas las capas
+  void bind_optimizer() {
+    vector<Parameter> params;
+    for (auto &layer : layers) {
+      if (layer->is_mapped()) {
+        optimizer.reset();
+        throw runtime_error("Modelo proyectado con map_model (solo inferencia): usar load_model para entrenar");
+      }
+      layer->collect_parameters(params);
+    }
+    optimizer->bind(params);
+  }
+
+  // Calcula error cuadratico medio (sumado sobre las filas del batch)
+  float mse(ConstTensorView y_pred, ConstTensorView y_true) const {
+    const size_t classes = y_true.shape.back();
     float sum = 0.0f;
-    for (size_t i = 0; i < y_true.shape[0]; ++i) {
-      float diff = y_pred({i}) - y_true({i}); // Diferencia entre prediccion y real
-      sum += diff * diff;                     // Suma cuadrado de la diferencia
+    for (size_t i = 0; i < y_true.get_size(); ++i) {
+      float diff = y_pred.data[i] - y_true.data[i]; // Diferencia entre prediccion y real
+      sum += diff * diff;                           // Suma cuadrado de la diferencia
     }
-    return sum / y_true.shape[0]; // Retorna promedio
+    return sum / classes; // Retorna promedio por muestra
   }
 
-  // Derivada de MSE
-  Tensor mse_derivative(const Tensor &y_pred, const Tensor &y_true) const {
-    Tensor grad({y_true.shape[0]}); // Gradiente del mismo tamaño
-    for (size_t i = 0; i < y_true.shape[0]; ++i)
-      grad({i}) = 2.0f * (y_pred({i}) - y_true({i})) / y_true.shape[0];
-    return grad; // Retorna Derivada del error (perdida)
+  // Derivada de MSE (escrita en 'grad', de la misma forma que y_true)
+  void mse_derivative(ConstTensorView y_pred, ConstTensorView y_true, TensorView grad) const {
+    const size_t classes = y_true.shape.back();
+    for (size_t i = 0; i < y_true.get_size(); ++i)
+      grad.data[i] = 2.0f * (y_pred.data[i] - y_true.data[i]) / classes;
   }
 
-  float cross_entropy(const Tensor &pred, const Tensor &target) const {
+  float cross_entropy(ConstTensorView pred, ConstTensorView target) const {
     float loss = 0.0f;
-    const auto &p = pred.data;
-    const auto &t = target.data;
-    for (size_t i = 0; i < p.size(); ++i)
+    const float *p = pred.data;
+    const float *t = target.data;
+    for (size_t i = 0; i < pred.get_size(); ++i)
       loss -= t[i] * std::log(std::max(p[i], 1e-8f)); // evitar log(0)
     return loss;                                      // perdida escalar por muestra
   }
 
-  Tensor cross_entropy_derivative(const Tensor &pred, const Tensor &target) const {
-    const auto &p = pred.data;
-    const auto &t = target.data;
-    Tensor grad(pred.shape);
-    auto &g = grad.data;
-    for (size_t i = 0; i < p.size(); ++i) {
+  void cross_entropy_derivative(ConstTensorView pred, ConstTensorView target, TensorView grad) const {
+    const float *p = pred.data;
+    const float *t = target.data;
+    float *g = grad.data;
+    for (size_t i = 0; i < pred.get_size(); ++i) {
       g[i] = p[i] - t[i]; // simplificacion de softmax + cross-entropy
     }
-    return grad;
   }
 
-  float compute_total_loss(const Tensor &y_pred, const Tensor &y_true) const {
-    float loss = 0.0f;
+  // Perdida sumada sobre las filas del batch
+  float compute_loss(ConstTensorView y_pred, ConstTensorView y_true) const {
+    return (error_function == "cross-entropy") ? cross_entropy(y_pred, y_true) : mse(y_pred, y_true);
+  }
 
+  // Gradiente de la perdida media del batch respecto a la prediccion. 'batch_rows' son
+  // las filas del batch completo cuando y_true es solo una parte (0 = las de y_true)
+  void loss_derivative(ConstTensorView y_pred, ConstTensorView y_true, TensorView grad, size_t batch_rows = 0) const {
+    if (error_function == "cross-entropy")
+      cross_entropy_derivative(y_pred, y_true, grad);
+    else
+      mse_derivative(y_pred, y_true, grad);
+    const size_t classes = y_true.shape.back();
+    const size_t total = batch_rows ? batch_rows * classes : y_true.get_size();
+    const float inv_rows = static_cast<float>(classes) / total;
+    for (size_t i = 0; i < grad.get_size(); ++i)
+      grad.data[i] *= inv_rows;
+  }
+
+  float compute_total_loss(ConstTensorView y_pred, ConstTensorView y_true) const {
     // Perdida original
-    if (error_function == "cross-entropy") {
-      loss = cross_entropy(y_pred, y_true);
-    } else {
-      loss = mse(y_pred, y_true);
-    }
+    float loss = compute_loss(y_pred, y_true);
 
     // Termino L2 (Weight Decay) de todas las capas
     float l2_term = 0.0f;
@@ -107,103 +237,163 @@ public:
     return loss + l2_term;
   }
 
-  float accuracy(const Tensor &y_pred, const Tensor &y_true) const {
-    int pred_class = argmax(y_pred);
-    int true_class = argmax(y_true);
-    return (pred_class == true_class) ? 1.0f : 0.0f;
+  // Numero de aciertos en el batch (una fila por muestra)
+  float accuracy(ConstTensorView y_pred, ConstTensorView y_true) const {
+    const size_t classes = y_true.shape.back();
+    const size_t rows = y_true.get_size() / classes;
+    float correct = 0.0f;
+    for (size_t r = 0; r < rows; ++r) {
+      int pred_class = argmax(y_pred.data + r * classes, classes);
+      int true_class = argmax(y_true.data + r * classes, classes);
+      correct += (pred_class == true_class) ? 1.0f : 0.0f;
+    }
+    return correct;
   }
 
-  Tensor forward(const Tensor &input) const {
-    Tensor out = input;              // Salida inicial es la entrada
+  // Forward sin copias: cada capa recibe la vista de la salida anterior.
+  // Cada forward comienza un paso nuevo en la arena: el resultado apunta a ella
+  // y es valido hasta el siguiente forward. 'training' elige el plan de memoria
+  // (en entrenamiento las activaciones se conservan para el backward)
+  ConstTensorView forward_view(ConstTensorView input, bool training = false) const {
+    const MemoryPlan *plan = nullptr;
+    if (!planned_input.empty()) {
+      plan = training ? &training_plan : &inference_plan;
+    }
+    workspace->reset(plan);
+    ConstTensorView out = input;     // Salida inicial es la entrada
     for (const auto &layer : layers) // Itera sobre cada capa
       out = layer->forward(out);     // Pasa la salida a la siguiente capa
     return out;                      // Retorna la salida final
   }
 
+  // Inferencia sin estado: no modifica la red ni su arena, solo 'ws'. Varios hilos
+  // pueden usar la misma red a la vez, cada uno con su propia arena. El resultado
+  // apunta a 'ws' y es valido hasta el siguiente uso de esa arena
+  ConstTensorView infer(ConstTensorView input, Workspace &ws) const {
+    const MemoryPlan *plan = nullptr;
+    if (!planned_input.empty()) {
+      if (ws.planned_size() < inference_plan.size) {
+        ws.reserve_planned(inference_plan.size);
+      }
+      plan = &inference_plan;
+    }
+    ws.reset(plan);
+    ConstTensorView out = input;
+    for (const Layer *step : inference_layers)
+      out = step->infer(out, ws);
+    return out;
+  }
+
+  // Fusion de capas en inferencia (Fusion.hpp; activada por defecto). Desactivarla recorre
+  // las capas una por una, p. ej. para comparar resultados o tiempos
+  void set_layer_fusion(bool enabled) {
+    layer_fusion = enabled;
+    build_inference_graph();
+  }
+
+  // Pasos que recorre la inferencia (capas o pasos fusionados)
+  size_t inference_steps() const { return inference_layers.size(); }
+
+  // Salida en modo inferencia como Tensor propio (arena del hilo que llama)
+  Tensor forward(const Tensor &input) const { return infer(input, thread_workspace()).clone(); }
+
+  // Paso de entrenamiento sobre un batch: las activaciones del unico forward pass
+  // se reutilizan para las metricas y para el backward (las capas las guardan en cache)
+  // Devuelve la perdida sumada del batch y escribe el numero de aciertos en 'correct'
+  float train_step(const Tensor &X_batch, const Tensor &Y_batch, float &correct) {
+    // 1-2. Forward, perdida y backward (en paralelo por partes si hay data-parallel)
+    const bool sharded = shards > 1 && X_batch.shape.size() >= 2 && X_batch.shape[0] > 1;
+    float batch_loss = sharded ? sharded_gradients(X_batch, Y_batch, correct)
+                               : accumulate_gradients(X_batch, Y_batch, 0, correct, communicator != nullptr);
+
+    // Promedio de los gradientes entre procesos (encolado capa por capa durante el backward)
+    if (communicator) {
+      if (sharded) {
+        for (size_t j = layers.size(); j-- > 0;) {
+          reduce_layer_gradients(j);
+        }
+      }
+      communicator->wait();
+    }
+
+    // 3. Actualizar todos los parametros en un solo paso del optimizador
+    if (!optimizer->is_bound()) {
+      bind_optimizer();
+    }
+    optimizer->step();
+    for (auto &layer : layers) {
+      layer->parameters_updated();
+    }
+
+    return batch_loss;
+  }
+
   // Entrenamiento con multiples ejemplos por varias epocas
   void fit(const vector<Tensor> &X, const vector<Tensor> &Y, const vector<Tensor> &X_valid, const vector<Tensor> &Y_valid,
-           int epochs, int batch_size = 1, int verbose_every = 1000, bool training_logs = false) {
+           int epochs, int batch_size = 1, int verbose_every = 1000, bool training_logs = false, bool shuffle = true) {
+    fit(TensorDataset(X, Y), TensorDataset(X_valid, Y_valid), epochs, batch_size, verbose_every, training_logs, shuffle);
+  }
+
+  // Entrenamiento sobre datasets: los batches los prepara un DataLoader en segundo plano
+  // (mezclados en cada epoca si 'shuffle') mientras se entrena con el batch anterior
+  void fit(const Dataset &train, const Dataset &valid, int epochs, int batch_size = 1, int verbose_every = 1000,
+           bool training_logs = false, bool shuffle = true) {
 
     if (!optimizer)
       throw std::runtime_error("Modelo no compilado. Llamar a 'compile()' primero.");
 
+    // Formas validadas y plan de memoria listos antes de la primera epoca
+    Shape batch_shape{static_cast<size_t>(batch_size)};
+    for (size_t dim : train.sample_shape())
+      batch_shape.push_back(dim);
+    if (batch_shape != planned_input)
+      plan_memory(batch_shape);
+    if (valid.size() > 0 && valid.sample_shape() != train.sample_shape())
+      throw std::invalid_argument("fit: las muestras de validacion no tienen la forma de las de entrenamiento");
+    const Shape output = infer_shapes(batch_shape).back();
+    if (output.back() != train.label_size()) {
+      std::ostringstream msg;
+      msg << "fit: la red produce " << output << " y las etiquetas tienen " << train.label_size() << " valores";
+      throw std::invalid_argument(msg.str());
+    }
+
     std::ofstream log_file;
     if (training_logs) {
       log_file.open("log_" + to_string(epochs) + "ep.txt");
       log_file << "Epoch,Train_Loss,Train_Accuracy,Valid_Loss,Valid_Accuracy\n";
     }
 
+    DataLoader train_loader(train, batch_size, shuffle, shuffle_seed, augmentation);
+    DataLoader valid_loader(valid, batch_size, false);
+    const Tensor *X_batch, *Y_batch;
+
     for (int epoch = 1; epoch <= epochs; epoch++) {
       // Entrenamiento
       auto start = start_timer();
       float total_train_loss = 0.0f;
       float total_train_accuracy = 0.0f;
-      int num_batches = (X.size() + batch_size - 1) / batch_size;
+      train_loader.start_epoch(step_seed(shuffle_seed, optimizer->steps()));
 
       // Modo entrenamiento para Dropout
-      for (const auto &layer : layers) {
-        if (auto dropout_layer = dynamic_cast<Dropout *>(layer.get())) {
-          dropout_layer->set_training_mode(true);
-        }
-      }
-
-      for (int batch_idx = 0; batch_idx < num_batches; batch_idx++) {
-        // Calcular indices del batch actual
-        int start_idx = batch_idx * batch_size;
-        int end_idx = min(start_idx + batch_size, (int)X.size());
+      set_training(true);
 
-        // Procesar batch (forward + backward)
-        float batch_loss = 0.0f; // Perdida original
-        float batch_accuracy = 0.0f;
-        float batch_l2 = 0.0f; // Termino L2 acumulado
-
-        // 1. Forward pass y calculo de perdida base
-        for (int i = start_idx; i < end_idx; i++) {
-          Tensor pred = forward(X[i]);
+      // Cada batch llega ya agrupado en un solo tensor [N, ...]
+      while (train_loader.next(X_batch, Y_batch)) {
+        int current_batch_size = X_batch->shape[0];
 
-          if (error_function == "cross-entropy") {
-            batch_loss += cross_entropy(pred, Y[i]);
-          } else {
-            batch_loss += mse(pred, Y[i]);
-          }
-          batch_accuracy += accuracy(pred, Y[i]);
-        }
-
-        // 2. Calcular termino L2 de todas las capas Dense
+        // Termino L2 de todas las capas Dense (antes de actualizar los pesos)
+        float batch_l2 = 0.0f;
         for (const auto &layer : layers) {
           if (auto dense_layer = dynamic_cast<Dense *>(layer.get())) {
             batch_l2 += dense_layer->compute_l2_penalty();
           }
         }
 
-        for (auto &layer : layers) {
-          layer->zero_grad(); // <<<<<< INICIALIZA acumuladores en cero
-        }
-
-        // 3. Backward pass (igual que antes)
-        for (int i = start_idx; i < end_idx; i++) {
-          Tensor grad = (error_function == "cross-entropy") ? cross_entropy_derivative(forward(X[i]), Y[i])
-                                                            : mse_derivative(forward(X[i]), Y[i]);
-
-          for (int j = layers.size() - 1; j >= 0; j--) {
-            grad = layers[j]->backward(grad);
-          }
-        }
-
-        // 4. Normalizar gradientes (dividir entre batch_size) si necesario
-        int current_batch_size = end_idx - start_idx;
-        for (auto &layer : layers) {
-          if (auto dense_layer = dynamic_cast<Dense *>(layer.get())) {
-            dense_layer->scale_gradients(1.0f / current_batch_size); // <--
-          }
-        }
-
-        // 5. Actualizar parametros
-        for (auto &layer : layers) {
-          layer->update_parameters(*optimizer);
-        }
+        // Forward, perdida, backward y actualizacion con un solo forward pass
+        float batch_accuracy = 0.0f;
+        float batch_loss = train_step(*X_batch, *Y_batch, batch_accuracy); // Perdida original
 
-        // 5. Acumular metricas (perdida promedio del batch + L2)
+        // Acumular metricas (perdida promedio del batch + L2)
         // total_train_loss += (batch_loss / batch_size) + batch_l2;
         total_train_loss += (batch_loss + batch_l2) / current_batch_size;
         total_train_accuracy += batch_accuracy;
@@ -214,26 +404,20 @@ public:
       float total_valid_loss = 0.0f;
       float total_valid_accuracy = 0.0f;
 
-      for (const auto &layer : layers) {
-        if (auto dropout_layer = dynamic_cast<Dropout *>(layer.get())) {
-          dropout_layer->set_training_mode(false);
-        }
-      }
+      set_training(false);
 
-      for (size_t i = 0; i < X_valid.size(); i++) {
-        Tensor pred = predict(X_valid[i]);
-        if (error_function == "cross-entropy")
-          total_valid_loss += cross_entropy(pred, Y_valid[i]);
-        else
-          total_valid_loss += mse(pred, Y_valid[i]);
-        total_valid_accuracy += accuracy(pred, Y_valid[i]);
+      valid_loader.start_epoch();
+      while (valid_loader.next(X_batch, Y_batch)) {
+        ConstTensorView pred = infer(*X_batch, *workspace);
+        total_valid_loss += compute_loss(pred, *Y_batch);
+        total_valid_accuracy += accuracy(pred, *Y_batch);
       }
 
       // Calcular promedios
-      float avg_train_loss = total_train_loss / X.size() * batch_size;
-      float avg_train_acc = total_train_accuracy / X.size();
-      float avg_valid_loss = total_valid_loss / X_valid.size();
-      float avg_valid_acc = total_valid_accuracy / X_valid.size();
+      float avg_train_loss = total_train_loss / train.size() * batch_size;
+      float avg_train_acc = total_train_accuracy / train.size();
+      float avg_valid_loss = total_valid_loss / valid.size();
+      float avg_valid_acc = total_valid_accuracy / valid.size();
 
       // Logging
       if (verbose_every > 0 && (epoch % verbose_every == 0 || epoch == epochs)) {
@@ -255,18 +439,193 @@ public:
       log_file.close();
   }
 
-  // Realizar una prediccion con la red neuronal
+  // Realizar una prediccion con la red neuronal (una muestra o un batch [N, ...])
+  // Es const y reentrante: se puede llamar desde varios hilos a la vez.
+  // Los batches de mas de 'inference_batch' filas se parten en tramos (vistas sin
+  // copia) que se reparten entre los hilos de OpenMP, cada uno con su arena: la
+  // memoria de trabajo no crece con N. Un batch pequeño lo reparten las capas.
   Tensor predict(const Tensor &input) const {
-    // Todas las capas Dropout deben estar en modo de inferencia
-    for (const auto &layer : layers) {
+    if (input.shape.size() < 2 || input.shape[0] <= inference_batch) {
+      return forward(input);
+    }
+
+    // Las formas se validan antes: una excepcion no puede salir de la region paralela
+    const size_t rows = input.shape[0];
+    Tensor output(infer_shapes(input.shape).back());
+    const size_t row_size = output.get_size() / rows;
+
+    const size_t threads = in_parallel_region() ? 1 : static_cast<size_t>(thread_count());
+    const size_t chunk = std::min(inference_batch, (rows + threads - 1) / threads);
+    const size_t chunks = (rows + chunk - 1) / chunk;
+    const ConstTensorView all = input;
+
+    #pragma omp parallel for schedule(dynamic) if (threads > 1 && chunks > 1)
+    for (size_t c = 0; c < chunks; ++c) {
+      const size_t start = c * chunk;
+      const size_t end = std::min(rows, start + chunk);
+      ConstTensorView out = infer(all.slice(start, end), thread_workspace());
+      std::copy(out.data, out.data + out.get_size(), output.data.begin() + start * row_size);
+    }
+    return output;
+  }
+
+  // Prediccion de varias muestras sueltas (misma forma) en un solo batch [N, ...]
+  Tensor predict_batch(const vector<Tensor> &samples) const {
+    if (samples.empty()) {
+      throw std::invalid_argument("predict_batch: no hay muestras");
+    }
+    return predict(stack_batch(samples, 0, samples.size()));
+  }
+
+  // Cuantizacion int8 post-entrenamiento (Quantize.hpp): calibra el rango de la entrada
+  // de cada Dense / Conv2D con las primeras 'samples' muestras de 'calibration' y las
+  // reemplaza por QuantizedDense / QuantizedConv2D (pesos int8 por canal, acumulacion
+  // int32). La red queda solo para inferencia; save_model guarda los pesos int8
+  void quantize(const Dataset &calibration, size_t samples = 1000, size_t batch = 100) {
+    if (mapped_model) {
+      throw runtime_error("quantize: el modelo esta proyectado con map_model; cargarlo con load_model");
+    }
+    samples = std::min(samples, calibration.size());
+    if (samples == 0 || batch == 0) {
+      throw std::invalid_argument("quantize: no hay muestras de calibracion");
+    }
+
+    // Rango de la entrada de cada capa sobre las muestras de calibracion (en fp32)
+    vector<float> lo(layers.size(), 0.0f), hi(layers.size(), 0.0f);
+    Workspace ws;
+    Tensor X_batch, Y_batch;
+    for (size_t start = 0; start < samples; start += batch) {
+      calibration.get_batch(start, std::min(samples, start + batch), X_batch, Y_batch);
+      ws.reset();
+      ConstTensorView x = X_batch;
+      for (size_t i = 0; i < layers.size(); ++i) {
+        if (dynamic_cast<Dense *>(layers[i].get()) || dynamic_cast<Conv2D *>(layers[i].get())) {
+          const auto range = std::minmax_element(x.data, x.data + x.get_size());
+          lo[i] = std::min(lo[i], *range.first);
+          hi[i] = std::max(hi[i], *range.second);
+        }
+        x = layers[i]->infer(x, ws);
+      }
+    }
+
+    for (size_t i = 0; i < layers.size(); ++i) {
+      const ActivationQuant input_quant = ActivationQuant::from_range(lo[i], hi[i]);
+      if (auto dense_layer = dynamic_cast<Dense *>(layers[i].get())) {
+        layers[i] = make_unique<QuantizedDense>(*dense_layer, input_quant);
+      } else if (auto conv_layer = dynamic_cast<Conv2D *>(layers[i].get())) {
+        layers[i] = make_unique<QuantizedConv2D>(*conv_layer, input_quant);
+      } else {
+        continue;
+      }
+      layers[i]->set_workspace(workspace.get());
+      layers[i]->set_training(training_mode);
+    }
+
+    // Sin parametros entrenables: fuera el optimizador, las replicas y el plan anterior
+    optimizer.reset();
+    replicas.clear();
+    parameters.clear();
+    layer_parameters.clear();
+    build_inference_graph();
+  }
+
+  // Tipo de almacenamiento de los pesos de Dense y Conv2D (FLOAT32, BF16 o FP16): el
+  // forward los lee en ese tipo y acumula en fp32; save_model(..., false) los guarda asi.
+  // Si la red esta compilada se entrena igual que en fp32: el optimizador actualiza la
+  // copia maestra fp32 de cada peso y redondea despues de cada paso
+  void set_precision(DType dtype) {
+    if (mapped_model) {
+      throw runtime_error("set_precision: el modelo esta proyectado con map_model; cargarlo con load_model");
+    }
+    const bool keep_master = optimizer && optimizer->is_bound();
+    for (auto &layer : layers) {
+      layer->set_precision(dtype, keep_master);
+    }
+    replicas.clear();
+  }
+
+  // Bytes que ocupan los pesos de la red: parametros (en su tipo de almacenamiento,
+  // sin la copia maestra) y buffers (p. ej. pesos int8)
+  size_t weight_bytes() {
+    size_t bytes = 0;
+    for (auto &layer : layers) {
+      vector<Parameter> params;
+      vector<LayerBuffer> buffers;
+      layer->collect_parameters(params);
+      layer->collect_buffers(buffers);
+      for (const Parameter &param : params) bytes += param.value->shape.numel() * dtype_size(param.value->dtype);
+      for (const LayerBuffer &buffer : buffers) bytes += buffer.bytes;
+    }
+    return bytes;
+  }
+
+  // Entrenamiento data-parallel: cada batch se parte en 'count' partes contiguas que
+  // hacen forward + backward a la vez (una por hilo, cada una con sus caches, gradientes
+  // y arena) y los gradientes se suman en arbol antes del paso del optimizador.
+  // El orden de las sumas es fijo: con el mismo 'count' el entrenamiento da exactamente
+  // el mismo resultado con cualquier numero de hilos. 1 = desactivado
+  void set_data_parallel(size_t count) {
+    if (count == 0) {
+      throw std::invalid_argument("set_data_parallel: count debe ser mayor que cero");
+    }
+    shards = count;
+    replicas.clear();
+  }
+
+  // Entrenamiento distribuido en varios procesos (p. ej. uno por maquina): cada proceso
+  // llama a fit() con su parte del dataset (DatasetShard) y antes de cada paso del
+  // optimizador los gradientes se promedian entre todos con all-reduce en anillo. La
+  // reduccion de cada capa se solapa con el backward de las capas anteriores. Los pesos
+  // iniciales se copian del rank 0 para que todos los procesos partan iguales
+  void set_distributed(RingCommunicator &comm) {
+    communicator = &comm;
+    replicas.clear(); // Las semillas de Dropout dependen del rank
+    collect_layer_parameters();
+    for (const Parameter &param : parameters) {
+      Tensor &value = *param.value;
+      if (is_half(value.dtype) && !value.has_master()) {
+        value.widen_master();
+      }
+      comm.broadcast(value.data.data(), value.data.size());
+      if (is_half(value.dtype)) {
+        value.narrow_master(0, value.data.size());
+      }
+    }
+    for (auto &layer : layers) {
       if (auto dropout_layer = dynamic_cast<Dropout *>(layer.get())) {
-        dropout_layer->set_training_mode(false);
+        dropout_layer->set_seed(static_cast<unsigned>(comm.rank() + 1)); // Mascaras distintas en cada proceso
       }
+      layer->parameters_updated();
+    }
+  }
+
+  // Filas por tramo en predict() para batches grandes
+  void set_inference_batch(size_t rows) {
+    if (rows == 0) {
+      throw std::invalid_argument("set_inference_batch: rows debe ser mayor que cero");
+    }
+    inference_batch = rows;
+  }
+
+  // Cambia el modo (entrenamiento / inferencia) de todas las capas; no hace nada
+  // si la red ya esta en ese modo
+  void set_training(bool training) {
+    if (training == training_mode) {
+      return;
     }
-    return forward(input);
+    for (const auto &layer : layers) {
+      layer->set_training(training);
+    }
+    training_mode = training;
   }
 
-  inline void save_model(const string &filename) {
+  // Guarda el modelo en models/<filename> (formato de ModelFile.hpp): arquitectura,
+  // parametros y, si 'include_optimizer' y la red esta compilada, el estado del
+  // optimizador para reanudar el entrenamiento
+  inline void save_model(const string &filename, bool include_optimizer = true) {
+    if (mapped_model) {
+      throw runtime_error("save_model: el modelo esta proyectado con map_model (el archivo ya existe)");
+    }
     const string dir_path = "models";
     const string full_path = dir_path + "/" + filename;
 
@@ -283,47 +642,362 @@ public:
     if (!file.is_open()) {
       throw runtime_error("Error: No se pudo abrir el archivo para guardar el modelo: " + full_path);
     }
-
-    // Recorremos cada capa de la red para guardar sus parámetros
-    for (const auto &layer : layers) {
-      // Si es una capa Densa, leemos pesos y bias
-      if (auto dense_layer = dynamic_cast<Dense *>(layer.get())) {
-        file.write(reinterpret_cast<const char *>(dense_layer->weights.data.data()),
-                   dense_layer->weights.get_size() * sizeof(float));
-        file.write(reinterpret_cast<const char *>(dense_layer->bias.data.data()), dense_layer->bias.get_size() * sizeof(float));
-      }
-      // Si es una capa Convolucional, leemos kernels y bias
-      else if (auto conv_layer = dynamic_cast<Conv2D *>(layer.get())) {
-        file.write(reinterpret_cast<const char *>(conv_layer->kernels.data.data()),
-                   conv_layer->kernels.get_size() * sizeof(float));
-        file.write(reinterpret_cast<const char *>(conv_layer->bias.data.data()), conv_layer->bias.get_size() * sizeof(float));
-      }
+    collect_layer_parameters();
+    const bool with_optimizer = include_optimizer && optimizer && optimizer->is_bound();
+    model_file::Graph graph;
+    graph.loss = error_function;
+    graph.input_shape = planned_input;
+    if (with_optimizer) {
+      graph.optimizer = optimizer_config.name;
+      graph.learning_rate = optimizer_config.learning_rate;
+      graph.beta1 = optimizer_config.beta1;
+      graph.beta2 = optimizer_config.beta2;
     }
-
+    model_file::write_model(file, graph, layers, parameters, layer_parameters,
+                            with_optimizer ? optimizer.get() : nullptr);
     file.close();
+    if (!file) {
+      throw runtime_error("Error al escribir el modelo en: " + full_path);
+    }
     cout << "Modelo guardado exitosamente en '" << full_path << "'" << endl;
   }
 
+  // Carga un modelo guardado con save_model. Si la red no tiene capas la arquitectura
+  // se arma desde el archivo (no hace falta conocerla); si ya las tiene, deben coincidir.
+  // Si el archivo trae el estado del optimizador la red queda compilada con el y el
+  // entrenamiento continua donde quedo. Tambien lee el formato anterior (solo floats,
+  // con la arquitectura ya armada)
   inline void load_model(const string &filepath) {
-    ifstream file(filepath, ios::binary);
+    if (mapped_model) {
+      throw runtime_error("load_model: la red usa un modelo proyectado con map_model; cargar en una red nueva");
+    }
+    ifstream file(filepath, ios::binary | ios::ate);
     if (!file.is_open()) {
       throw runtime_error("Error: No se pudo abrir el archivo para cargar el modelo: " + filepath);
     }
+    vector<unsigned char> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+    if (!file) {
+      throw runtime_error("Error al leer el modelo: " + filepath);
+    }
+
+    if (model_file::has_magic(bytes.data(), bytes.size())) {
+      read_model(bytes.data(), bytes.size(), false, true);
+    } else {
+      model_file::read_legacy_model(bytes.data(), bytes.size(), layers);
+    }
+    mapped_model.reset();
+    for (auto &layer : layers) {
+      layer->parameters_updated(); // Caches que dependen de los pesos (Winograd)
+    }
+  }
+
+  // Carga de solo lectura para inferencia: proyecta el archivo (formato de ModelFile.hpp)
+  // con mmap y las capas leen los pesos directamente de la proyeccion, sin reservarlos,
+  // inicializarlos ni copiarlos. El arranque cuesta lo que los fallos de pagina, y varios
+  // procesos que sirven el mismo archivo comparten sus paginas. La red no se puede
+  // entrenar (compile lanza error). Los CRC de los pesos solo se comprueban con
+  // 'verify_checksums' (obliga a leer todo el archivo); los del grafo y la tabla siempre
+  inline void map_model(const string &filepath, bool verify_checksums = false) {
+    auto file = make_shared<const MappedFile>(filepath);
+    if (!model_file::has_magic(file->data(), file->size())) {
+      throw runtime_error("map_model: '" + filepath + "' no tiene el formato versionado (usar load_model)");
+    }
+    if (optimizer) {
+      throw runtime_error("map_model: la red esta compilada para entrenar");
+    }
+    read_model(file->data(), file->size(), true, verify_checksums);
+    mapped_model = std::move(file); // Las capas apuntan a la proyeccion mientras viva la red
+  }
+
+private:
+  // Forward + perdida + backward de un batch (o de una parte de 'batch_rows' filas):
+  // deja los gradientes en las capas y devuelve la perdida sumada. Con 'reduce_layers'
+  // los gradientes de cada capa se envian a reducir entre procesos apenas estan listos
+  float accumulate_gradients(ConstTensorView X_batch, ConstTensorView Y_batch, size_t batch_rows, float &correct,
+                             bool reduce_layers = false) {
+    // 1. Forward pass y calculo de perdida base
+    ConstTensorView pred = forward_view(X_batch, true);
+    float batch_loss = compute_loss(pred, Y_batch);
+    correct = accuracy(pred, Y_batch);
 
-    // Recorremos cada capa para cargar los datos en el orden correcto
     for (auto &layer : layers) {
-      // Si es una capa Densa, leemos pesos y bias
-      if (auto dense_layer = dynamic_cast<Dense *>(layer.get())) {
-        file.read(reinterpret_cast<char *>(dense_layer->weights.data.data()), dense_layer->weights.get_size() * sizeof(float));
-        file.read(reinterpret_cast<char *>(dense_layer->bias.data.data()), dense_layer->bias.get_size() * sizeof(float));
+      layer->zero_grad(); // <<<<<< INICIALIZA acumuladores en cero
+    }
+
+    // 2. Backward pass del batch completo (gradiente ya promediado por batch)
+    TensorView loss_grad = workspace->tensor(this, 0, pred.shape);
+    loss_derivative(pred, Y_batch, loss_grad, batch_rows);
+    ConstTensorView grad = loss_grad;
+    for (int j = layers.size() - 1; j >= 0; j--) {
+      grad = layers[j]->backward(grad);
+      if (reduce_layers) {
+        reduce_layer_gradients(j); // Se reduce mientras corre el backward de la capa j - 1
+      }
+    }
+    return batch_loss;
+  }
+
+  // Lista de parametros de las capas (una sola vez por arquitectura)
+  void collect_layer_parameters() {
+    if (!layer_parameters.empty()) {
+      return;
+    }
+    layer_parameters.push_back(0);
+    for (auto &layer : layers) {
+      layer->collect_parameters(parameters);
+      layer_parameters.push_back(parameters.size());
+    }
+  }
+
+  // Encola el promedio entre procesos de los gradientes de la capa j
+  void reduce_layer_gradients(size_t j) {
+    collect_layer_parameters();
+    const float scale = 1.0f / communicator->size();
+    for (size_t i = layer_parameters[j]; i < layer_parameters[j + 1]; ++i) {
+      vector<float> &grad = parameters[i].grad->data;
+      communicator->all_reduce_async(grad.data(), grad.size(), scale);
+    }
+  }
+
+  // Red que procesa la parte k del batch en el entrenamiento data-parallel
+  NeuralNetwork &shard_network(size_t k) { return k == 0 ? *this : *replicas[k - 1]; }
+
+  // Forward + backward data-parallel: la parte k del batch la procesa shard_network(k)
+  // y los gradientes quedan sumados en las capas de esta red
+  float sharded_gradients(const Tensor &X_batch, const Tensor &Y_batch, float &correct) {
+    const size_t rows = X_batch.shape[0];
+    const size_t parts = std::min(shards, rows);
+    if (Y_batch.shape.size() < 2 || Y_batch.shape[0] != rows) {
+      throw std::invalid_argument("train_step: X e Y tienen distinto numero de filas");
+    }
+
+    // Las formas se validan al planificar las replicas: una excepcion no puede salir
+    // de la region paralela
+    Shape part_shape = X_batch.shape;
+    part_shape[0] = (rows + parts - 1) / parts;
+    prepare_replicas(parts, part_shape);
+
+    part_metrics.resize(parts);
+    const ConstTensorView X = X_batch, Y = Y_batch;
+    #pragma omp parallel for schedule(static, 1)
+    for (size_t k = 0; k < parts; ++k) {
+      const size_t begin = k * rows / parts, end = (k + 1) * rows / parts;
+      auto &[part_loss, part_correct] = part_metrics[k];
+      part_loss = shard_network(k).accumulate_gradients(X.slice(begin, end), Y.slice(begin, end), rows, part_correct);
+    }
+    reduce_gradients(parts);
+
+    float batch_loss = 0.0f;
+    correct = 0.0f;
+    for (size_t k = 0; k < parts; ++k) {
+      batch_loss += part_metrics[k].first;
+      correct += part_metrics[k].second;
+    }
+    return batch_loss;
+  }
+
+  // Semilla del flujo 'stream' en el paso 'step'. Se deriva del paso del optimizador (que va
+  // en el checkpoint) en lugar de arrastrar el estado de un generador, asi al reanudar se
+  // repiten las mismas mascaras de Dropout de las replicas y el mismo orden de los datos
+  static unsigned step_seed(uint64_t stream, size_t step) {
+    uint64_t z = (static_cast<uint64_t>(step) << 32) ^ stream; // Mezcla de splitmix64
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<unsigned>(z ^ (z >> 31));
+  }
+
+  // Flujo de Dropout de la parte k en el proceso 'rank' (distinto en cada parte y proceso)
+  static unsigned replica_seed(size_t rank, size_t k, size_t step) {
+    return step_seed((static_cast<uint64_t>(rank + 1) << 16) + k, step);
+  }
+
+  // Crea las replicas que falten, las planifica para 'part_shape', les copia los
+  // pesos actuales de esta red y fija las semillas de Dropout del paso
+  void prepare_replicas(size_t parts, const Shape &part_shape) {
+    collect_layer_parameters();
+    const size_t rank = communicator ? communicator->rank() : 0;
+    const size_t step = optimizer ? static_cast<size_t>(optimizer->steps()) : 0;
+    while (replicas.size() + 1 < parts) {
+      auto replica = make_unique<NeuralNetwork>(error_function);
+      for (const auto &layer : layers) {
+        unique_ptr<Layer> copy = layer->clone();
+        if (auto dense_layer = dynamic_cast<Dense *>(copy.get())) {
+          dense_layer->lambda = 0.0f; // El termino L2 lo suma solo la parte 0
+        }
+        replica->add_layer(std::move(copy));
       }
-      // Si es una capa Convolucional, leemos kernels y bias
-      else if (auto conv_layer = dynamic_cast<Conv2D *>(layer.get())) {
-        file.read(reinterpret_cast<char *>(conv_layer->kernels.data.data()), conv_layer->kernels.get_size() * sizeof(float));
-        file.read(reinterpret_cast<char *>(conv_layer->bias.data.data()), conv_layer->bias.get_size() * sizeof(float));
+      replica->collect_layer_parameters();
+      replicas.push_back(std::move(replica));
+    }
+    for (size_t r = 0; r + 1 < parts; ++r) {
+      if (replicas[r]->planned_input != part_shape) {
+        replicas[r]->plan_memory(part_shape);
       }
     }
 
-    file.close();
+    #pragma omp parallel for
+    for (size_t r = 0; r < parts - 1; ++r) {
+      NeuralNetwork &replica = *replicas[r];
+      replica.error_function = error_function;
+      for (size_t i = 0; i < parameters.size(); ++i) {
+        const Tensor &src = *parameters[i].value;
+        Tensor &dst = *replica.parameters[i].value;
+        std::copy(src.data.begin(), src.data.end(), dst.data.begin());
+        std::copy(src.half.begin(), src.half.end(), dst.half.begin()); // Pesos en 16 bits
+      }
+      for (auto &layer : replica.layers) {
+        layer->parameters_updated();
+        if (auto dropout_layer = dynamic_cast<Dropout *>(layer.get())) {
+          dropout_layer->set_seed(replica_seed(rank, r + 1, step)); // Mascaras distintas en cada parte
+        }
+      }
+    }
+  }
+
+  // Suma en arbol de los gradientes de las partes: en cada nivel la parte k acumula la
+  // k + stride. El orden es fijo, asi que el resultado no depende del numero de hilos
+  void reduce_gradients(size_t parts) {
+    const simd::Kernels &kern = simd::kernels();
+    const size_t count = parameters.size();
+    for (size_t stride = 1; stride < parts; stride *= 2) {
+      const size_t pairs = (parts - stride + 2 * stride - 1) / (2 * stride);
+      #pragma omp parallel for collapse(2) schedule(dynamic)
+      for (size_t p = 0; p < pairs; ++p) {
+        for (size_t i = 0; i < count; ++i) {
+          const size_t dst = 2 * stride * p;
+          Tensor &to = *shard_network(dst).parameters[i].grad;
+          const Tensor &from = *shard_network(dst + stride).parameters[i].grad;
+          kern.axpy(1.0f, from.data.data(), to.data.data(), to.data.size());
+        }
+      }
+    }
+  }
+
+  // Lee un modelo en el formato de ModelFile.hpp (ya verificado el numero magico): arma o
+  // compara la arquitectura, compila con el optimizador del archivo y carga los tensores.
+  // Con 'map' las capas apuntan a 'data' en vez de copiar los pesos
+  void read_model(const unsigned char *data, size_t size, bool map, bool verify_checksums) {
+    const model_file::FileHeader header = model_file::read_header(data, size);
+    const model_file::Graph graph = model_file::read_graph(data, header);
+    if (layers.empty()) {
+      for (const string &config : graph.layers) add_layer(model_file::make_layer(config, !map));
+    } else {
+      model_file::match_layers(layers, graph.layers);
+    }
+    collect_layer_parameters();
+
+    const string loss = graph.loss.empty() ? error_function : graph.loss;
+    const bool with_optimizer = !map && (header.flags & model_file::HAS_OPTIMIZER) != 0;
+    if (with_optimizer) {
+      compile(loss, graph.optimizer, graph.learning_rate, graph.beta1, graph.beta2);
+      optimizer->set_steps(graph.steps);
+    } else {
+      error_function = loss;
+    }
+    model_file::read_tensors(data, size, header, layers, parameters, layer_parameters,
+                             with_optimizer ? optimizer.get() : nullptr, map, verify_checksums);
+
+    if (!graph.input_shape.empty() && planned_input.empty()) {
+      plan_memory(graph.input_shape);
+    }
+  }
+
+  // Arena de inferencia del hilo actual (compartida por todas las redes del hilo:
+  // los buffers se identifican por capa, asi que no se mezclan)
+  static Workspace &thread_workspace() {
+    static thread_local Workspace ws;
+    return ws;
+  }
+
+  // Secuencia de inferencia para las capas actuales; el plan de inferencia apunta a los
+  // pasos, asi que se rehace con ella
+  void build_inference_graph() {
+    if (layer_fusion) {
+      inference_layers = fuse_layers(layers, fused_layers);
+    } else {
+      fused_layers.clear();
+      inference_layers.clear();
+      for (const auto &layer : layers) inference_layers.push_back(layer.get());
+    }
+    if (!planned_input.empty()) {
+      plan_memory(planned_input);
+    }
+  }
+
+  // Intervalo de vida de cada buffer de la arena segun el cronograma de plan_memory()
+  // para la secuencia 'steps' (las capas o, en inferencia, la secuencia fusionada)
+  vector<BufferLifetime> buffer_lifetimes(const vector<const Layer *> &steps, const vector<Shape> &shapes,
+                                          bool training) const {
+    const size_t L = steps.size();
+    const size_t end = training ? 2 * L : L; // Despues del ultimo uso dentro del paso
+    auto backward_time = [&](size_t i) { return 2 * L - i; };
+
+    // Ultimo lector del gradiente que sale del backward de la capa 'i' (o de la perdida si i == L):
+    // las capas que pueden devolver una vista lo pasan a la anterior
+    auto grad_reader = [&](size_t i) {
+      size_t j = i;
+      while (j > 0) {
+        --j;
+        if (!steps[j]->may_alias_input()) return backward_time(j);
+      }
+      return end;
+    };
+
+    vector<BufferLifetime> lifetimes;
+    vector<BufferRequest> requests;
+    for (size_t i = 0; i < L; ++i) {
+      requests.clear();
+      steps[i]->buffer_requests(shapes[i], requests);
+
+      for (const auto &r : requests) {
+        size_t first = i, last = i;
+        switch (r.use) {
+        case BufferUse::OUTPUT:
+          if (training) {
+            // La lee el forward de las capas siguientes y el backward de la siguiente
+            // (el backward de las capas posteriores ocurre antes). Si las capas que la leen
+            // (la siguiente y las que la dejan pasar como vista) no la usan en el backward,
+            // basta hasta el forward de la primera que no la deja pasar
+            size_t j = i + 1;
+            bool backward_reads = false;
+            for (; j < L && steps[j]->may_alias_input(); ++j) {
+              backward_reads = backward_reads || steps[j]->backward_reads_input();
+            }
+            backward_reads = backward_reads || (j < L && steps[j]->backward_reads_input());
+            last = backward_reads ? backward_time(i + 1) : j; // j == L: la lee la perdida
+          } else {
+            // Hasta el forward de la primera capa que no la deja pasar como vista
+            size_t j = i + 1;
+            while (j < L && steps[j]->may_alias_input()) ++j;
+            last = (j < L) ? j : end;
+          }
+          break;
+        case BufferUse::SAVED:
+          last = training ? backward_time(i) : i;
+          break;
+        case BufferUse::FORWARD_SCRATCH:
+          break;
+        case BufferUse::GRAD_INPUT:
+          if (!training) continue;
+          first = backward_time(i);
+          last = grad_reader(i);
+          break;
+        case BufferUse::BACKWARD_SCRATCH:
+          if (!training) continue;
+          first = last = backward_time(i);
+          break;
+        }
+        lifetimes.push_back({{steps[i], r.slot}, r.count, first, last});
+      }
+    }
+
+    // Gradiente de la perdida (lo pide train_step)
+    if (training) {
+      lifetimes.push_back({{this, 0}, shapes.back().numel(), L, grad_reader(L)});
+    }
+    return lifetimes;
   }
 };
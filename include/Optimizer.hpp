@@ -1,41 +1,152 @@
 #pragma once
 
 #include "Tensor.hpp"
+#include "Simd.hpp"
 
 #include <vector>
 #include <string>
-#include <map>
-#include <unordered_map>
 #include <cmath>
+#include <stdexcept>
+#include <omp.h>
 
 using namespace std;
 
+// Parametro entrenable de una capa: valores y gradiente acumulado (misma forma)
+struct Parameter {
+    Tensor *value;
+    Tensor *grad;
+};
+
+// Optimizador sobre todos los parametros del modelo a la vez:
+// - bind() registra los parametros y reserva UN buffer de estado contiguo y alineado
+//   (cada parametro ocupa un segmento alineado a 64 bytes dentro de cada slot)
+// - step() calcula lo que es comun al paso (p. ej. correcciones de sesgo) una sola vez
+//   y actualiza todo el modelo en una unica pasada paralela y vectorizada
+// Los parametros se guardan como Tensor* (no punteros a sus datos), asi que
+// una reasignacion del vector de datos no desincroniza el estado.
+// Un parametro en 16 bits (Tensor::dtype) se entrena sobre su copia maestra fp32:
+// bind() la crea si falta y step() la actualiza y redondea los valores en 16 bits.
 class Optimizer {
 protected:
+    // Tramo de un parametro que procesa un hilo
+    struct Chunk {
+        size_t param;  // Indice en 'params'
+        size_t begin;  // Primer elemento del tramo
+        size_t count;  // Numero de elementos
+    };
+
+    // Elementos por tramo (multiplo de 16 para no partir vectores)
+    static constexpr size_t CHUNK_SIZE = 16384;
+
     float learning_rate;
-    // Mapas para almacenar estados especificos de cada optimizador 
-    unordered_map<const float*, Tensor> m_moments; // Para Adam (1er momento)
-    unordered_map<const float*, Tensor> v_moments; // Para Adam (2do momento) / RMSProp (promedio de gradientes cuadrados)
-    unordered_map<const float*, int> t_steps;      // Para Adam (pasos temporales para correccion de sesgo)
+    vector<Parameter> params;
+    vector<size_t> sizes;            // Elementos de cada parametro al registrarlo
+    vector<size_t> offsets;          // Inicio de cada parametro dentro de un slot del estado
+    vector<Chunk> chunks;
+    size_t slot_size = 0;            // Floats por slot (suma de segmentos alineados)
+    bool bound = false;
+    int t = 0;                       // Pasos dados (comun a todos los parametros)
+    simd::aligned_vector<float> state; // state_slots() slots consecutivos de slot_size floats
+
+    // Numero de buffers de estado por parametro (0 SGD, 1 RMSProp, 2 Adam)
+    virtual size_t state_slots() const = 0;
+
+    // Preparacion comun a todo el paso (se llama una vez por step)
+    virtual void begin_step() {}
+
+    // Actualiza 'n' elementos contiguos; 'state' apunta al mismo tramo en el slot 0
+    // (el slot s esta en state + s * slot_size)
+    virtual void update_chunk(float *param, const float *grad, float *state, size_t n) const = 0;
 
 public:
     Optimizer(float lr) : learning_rate(lr) {}
     virtual ~Optimizer() = default;
 
-    // Metodo para actualizar los parametros de un tensor
-    virtual void update(vector<float>& param_data, const vector<float>& grad_data) = 0;
+    // Registra los parametros del modelo y reinicia el estado del optimizador
+    void bind(const vector<Parameter> &parameters) {
+        params = parameters;
+        sizes.clear();
+        offsets.clear();
+        chunks.clear();
+        slot_size = 0;
+
+        for (size_t p = 0; p < params.size(); ++p) {
+            if (!params[p].value || !params[p].grad ||
+                params[p].value->shape.numel() != params[p].grad->data.size()) {
+                throw std::invalid_argument("Optimizer: parametro y gradiente con tamaños distintos");
+            }
+            if (is_half(params[p].value->dtype) && !params[p].value->has_master()) {
+                params[p].value->widen_master();
+            }
+            const size_t size = params[p].value->data.size();
+            sizes.push_back(size);
+            offsets.push_back(slot_size);
+            slot_size += simd::align_floats(size);
+
+            for (size_t begin = 0; begin < size; begin += CHUNK_SIZE) {
+                chunks.push_back({p, begin, std::min(CHUNK_SIZE, size - begin)});
+            }
+        }
+
+        state.assign(state_slots() * slot_size, 0.0f);
+        bound = true;
+        t = 0;
+    }
+
+    bool is_bound() const { return bound; }
+
+    // Estado para guardar y reanudar el entrenamiento: 'slots()' buffers por parametro
+    // (p. ej. los momentos de Adam) y el numero de pasos dados
+    size_t slots() const { return state_slots(); }
+    size_t parameter_count() const { return params.size(); }
+
+    // Estado del parametro 'param' en el slot 'slot' (tantos floats como el parametro)
+    float *slot_data(size_t param, size_t slot) { return state.data() + slot * slot_size + offsets[param]; }
+    const float *slot_data(size_t param, size_t slot) const {
+        return state.data() + slot * slot_size + offsets[param];
+    }
+
+    int steps() const { return t; }
+    void set_steps(int count) { t = count; }
+
+    // Un paso de optimizacion sobre todos los parametros registrados
+    void step() {
+        if (!bound) {
+            throw std::runtime_error("Optimizer: llamar a bind() antes de step()");
+        }
+        for (size_t p = 0; p < params.size(); ++p) {
+            if (params[p].value->data.size() != sizes[p] || params[p].grad->data.size() != sizes[p]) {
+                throw std::runtime_error("Optimizer: un parametro cambio de tamaño despues de bind()");
+            }
+        }
+
+        t++;
+        begin_step();
+
+        #pragma omp parallel for schedule(static) if(chunks.size() > 1)
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            const Chunk &chunk = chunks[c];
+            const Parameter &param = params[chunk.param];
+            update_chunk(param.value->data.data() + chunk.begin, param.grad->data.data() + chunk.begin,
+                         state.data() + offsets[chunk.param] + chunk.begin, chunk.count);
+            if (is_half(param.value->dtype)) {
+                param.value->narrow_master(chunk.begin, chunk.count);
+            }
+        }
+    }
 };
 
 
 class SGD_Optimizer : public Optimizer {
-public:
-    SGD_Optimizer(float lr) : Optimizer(lr) {}
+protected:
+    size_t state_slots() const override { return 0; }
 
-    void update(vector<float>& param_data, const vector<float>& grad_data) override {
-        for (size_t i = 0; i < param_data.size(); ++i) {
-            param_data[i] -= learning_rate * grad_data[i];
-        }
+    void update_chunk(float *param, const float *grad, float *, size_t n) const override {
+        simd::kernels().axpy(-learning_rate, grad, param, n);
     }
+
+public:
+    SGD_Optimizer(float lr) : Optimizer(lr) {}
 };
 
 
@@ -44,31 +155,16 @@ private:
     float beta = 0.9f;      // Factor de decaimiento exponencial
     float epsilon = 1e-8f;  // Constante para evitar divisiones por cero
 
-public:
-    RMSProp_Optimizer(float lr, float beta_ = 0.9f) : Optimizer(lr), beta(beta_) {}
-
-    void update(vector<float>& param_data, const vector<float>& grad_data) override {
-        const float* param_key = param_data.data(); // Identificador unico del tensor de parametros
-
-        // Intentamos obtener el estado previo del acumulador v
-        auto v_it = v_moments.find(param_key);
-        if (v_it == v_moments.end()) {
-            // Si no existe, lo inicializamos en cero
-            v_it = v_moments.emplace(param_key, Tensor({param_data.size()})).first;
-            v_it->second.fill(0.0f);
-        }
-
-        auto& v_data = v_it->second.data;     // Referencia directa a los datos de v
-        const size_t size = param_data.size();
-        const float one_minus_beta = 1.0f - beta;   // Precomputamos para eficiencia
+protected:
+    size_t state_slots() const override { return 1; } // v: promedio de gradientes cuadrados
 
-        for (size_t i = 0; i < size; ++i) {
-            float g = grad_data[i];                // Gradiente actual
-            float& v = v_data[i];                  // Valor acumulado de v
-            v = beta * v + one_minus_beta * g * g; // Actualizacion de v con promedio exponencial
-            param_data[i] -= learning_rate * g / (std::sqrt(v) + epsilon); // Actualizacion del parametro
-        }
+    // v = beta * v + (1 - beta) * g^2;  p -= lr * g / (sqrt(v) + eps)
+    void update_chunk(float *param, const float *grad, float *v, size_t n) const override {
+        simd::kernels().rmsprop_update(param, grad, v, n, learning_rate, beta, epsilon);
     }
+
+public:
+    RMSProp_Optimizer(float lr, float beta_ = 0.9f) : Optimizer(lr), beta(beta_) {}
 };
 
 class Adam_Optimizer : public Optimizer {
@@ -76,50 +172,29 @@ private:
     float beta1;
     float beta2;
     float epsilon;
-    bool use_weight_decay;
     float lambda;
 
-public:
-    Adam_Optimizer(float lr, float beta1_ = 0.8f, float beta2_ = 0.9f, 
-                  float eps = 1e-6f, float lambda_ = 0.0f) 
-        : Optimizer(lr), beta1(beta1_), beta2(beta2_), 
-          epsilon(eps), lambda(lambda_) {}
-
-    void update(vector<float>& param_data, const vector<float>& grad_data) override {
-        const float* param_key = param_data.data();
-        
-        // Inicialización de momentos
-        if (m_moments[param_key].data.empty()) {
-            m_moments[param_key] = Tensor({param_data.size()});
-            v_moments[param_key] = Tensor({param_data.size()});
-            m_moments[param_key].fill(0.0f);
-            v_moments[param_key].fill(0.0f);
-            t_steps[param_key] = 0;
-        }
-
-        auto& m = m_moments[param_key].data;
-        auto& v = v_moments[param_key].data;
-        int& t = t_steps[param_key];
-        t++;
-
-        for (size_t i = 0; i < param_data.size(); ++i) {
-            float g = grad_data[i];
-            
-            // Weight decay
-            if (lambda > 0.0f) {
-                g += 2 * lambda * param_data[i];
-            }
+    float c1 = 1.0f;  // 1 / (1 - beta1^t)
+    float c2 = 1.0f;  // 1 / (1 - beta2^t)
 
-            // Actualización de momentos
-            m[i] = beta1 * m[i] + (1 - beta1) * g;
-            v[i] = beta2 * v[i] + (1 - beta2) * g * g;
+protected:
+    size_t state_slots() const override { return 2; } // m (1er momento) y v (2do momento)
 
-            // Corrección de sesgo
-            float m_hat = m[i] / (1 - pow(beta1, t));
-            float v_hat = v[i] / (1 - pow(beta2, t));
+    // Corrección de sesgo: una sola vez por paso
+    void begin_step() override {
+        c1 = 1.0f / (1.0f - std::pow(beta1, static_cast<float>(t)));
+        c2 = 1.0f / (1.0f - std::pow(beta2, static_cast<float>(t)));
+    }
 
-            // Actualización de parámetros
-            param_data[i] -= learning_rate * m_hat / (sqrt(v_hat) + epsilon);
-        }
+    // Momentos, weight decay y actualización de parámetros en un solo recorrido
+    void update_chunk(float *param, const float *grad, float *m, size_t n) const override {
+        float *v = m + slot_size;
+        simd::kernels().adam_update(param, grad, m, v, n, learning_rate, beta1, beta2, c1, c2, epsilon, lambda);
     }
-};
\ No newline at end of file
+
+public:
+    Adam_Optimizer(float lr, float beta1_ = 0.8f, float beta2_ = 0.9f,
+                  float eps = 1e-6f, float lambda_ = 0.0f)
+        : Optimizer(lr), beta1(beta1_), beta2(beta2_),
+          epsilon(eps), lambda(lambda_) {}
+};
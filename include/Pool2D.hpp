@@ -2,6 +2,7 @@
 #include "Tensor.hpp"
 #include "Layer.hpp"
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <string>
 
@@ -18,170 +19,264 @@ public:
     size_t pool_size;
     size_t stride;
     PoolingType type;
-    Tensor last_input;
+    Shape input_shape; // Forma de la entrada del ultimo forward (el backward no lee la entrada)
+
+    enum Buffer { OUTPUT, GRAD_INPUT, ARGMAX }; // Buffers en la arena
 
     Pooling2D(size_t pool_size = 2, size_t stride = 2, PoolingType type = PoolingType::MAX)
-        : pool_size(pool_size), stride(stride), type(type) {}
+        : pool_size(pool_size), stride(stride), type(type)
+    {
+        if (pool_size == 0 || pool_size > 256)
+        {
+            throw std::invalid_argument("Pooling2D: el tamaño de la ventana debe estar entre 1 y 256");
+        }
+    }
+
+    Shape output_shape(const Shape &input_shape) const override
+    {
+        if (input_shape.size() != 4 || input_shape[2] < pool_size || input_shape[3] < pool_size)
+        {
+            throw std::invalid_argument("Pooling2D: se esperaba una entrada [batch, channels, height, width] de al menos " +
+                                        std::to_string(pool_size) + "x" + std::to_string(pool_size));
+        }
+        return {input_shape[0], input_shape[1],
+                (input_shape[2] - pool_size) / stride + 1,
+                (input_shape[3] - pool_size) / stride + 1};
+    }
+
+    void buffer_requests(const Shape &input_shape, vector<BufferRequest> &requests) const override
+    {
+        const size_t outputs = output_shape(input_shape).numel();
+        requests.push_back({OUTPUT, outputs, BufferUse::OUTPUT});
+        if (type != PoolingType::AVERAGE)
+        {
+            requests.push_back({ARGMAX, argmax_floats(outputs), BufferUse::SAVED});
+        }
+        requests.push_back({GRAD_INPUT, input_shape.numel(), BufferUse::GRAD_INPUT});
+    }
+
+    // El backward solo usa los indices del maximo / minimo (o nada, con AVERAGE)
+    bool backward_reads_input() const override { return false; }
+
+    // Forward pass: con MAX / MIN guarda la posicion ganadora de cada ventana
+    ConstTensorView forward(ConstTensorView input) override
+    {
+        Workspace &ws = forward_workspace();
+        if (type == PoolingType::AVERAGE)
+        {
+            ConstTensorView output = infer(input, ws);
+            input_shape = input.shape;
+            return output;
+        }
+        const size_t outputs = output_shape(input.shape).numel();
+        argmax = ws.allocate(this, ARGMAX, argmax_floats(outputs));
+        ConstTensorView output = wide_index() ? pool(input, ws, reinterpret_cast<uint16_t *>(argmax))
+                                              : pool(input, ws, reinterpret_cast<uint8_t *>(argmax));
+        input_shape = input.shape;
+        return output;
+    }
 
-    Tensor forward(const Tensor &input) override
+    ConstTensorView infer(ConstTensorView input, Workspace &ws) const override
     {
-        last_input = input;
+        return pool(input, ws, static_cast<uint8_t *>(nullptr));
+    }
+
+    // Ventanas de las filas de salida [row_begin, row_end) de un plano [in_height, in_width]
+    // del que 'rows' solo tiene desde la fila 'first_row' (el camino fusionado de Fusion.hpp
+    // le pasa una banda); escribe las filas en 'out' [row_end - row_begin, out_width]
+    void pool_rows(const float *rows, size_t first_row, size_t in_height, size_t in_width,
+                   size_t row_begin, size_t row_end, float *out, size_t out_width) const
+    {
+        pool_rows(rows, first_row, in_height, in_width, row_begin, row_end, out, out_width,
+                  static_cast<uint8_t *>(nullptr));
+    }
+
+    // Backward pass: MAX / MIN devuelven el gradiente a la posicion guardada en el forward
+    // (una escritura por ventana); AVERAGE lo reparte en la ventana
+    ConstTensorView backward(ConstTensorView grad_output) override
+    {
+        require_contiguous(grad_output, "Pooling2D");
+        TensorView grad_input = backward_workspace().tensor(this, GRAD_INPUT, input_shape);
+        std::fill(grad_input.data, grad_input.data + grad_input.get_size(), 0.0f);
+
+        if (type == PoolingType::AVERAGE)
+        {
+            spread_average(grad_output, grad_input);
+        }
+        else if (wide_index())
+        {
+            scatter(grad_output, grad_input, reinterpret_cast<const uint16_t *>(argmax));
+        }
+        else
+        {
+            scatter(grad_output, grad_input, reinterpret_cast<const uint8_t *>(argmax));
+        }
+        return grad_input;
+    }
+
+    void zero_grad() override {}
+
+    void save(std::ostream &out) const override
+    {
+        const char *names[] = {"MAX", "MIN", "AVERAGE"};
+        out << "Pooling2D " << pool_size << " " << stride << " " << names[static_cast<int>(type)] << "\n";
+    }
+
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<Pooling2D>(*this); }
+
+private:
+    // Posicion ganadora de cada ventana (ph * pool_size + pw) del ultimo forward: uint8_t
+    // hasta ventanas de 16x16, uint16_t por encima (en la arena)
+    float *argmax = nullptr;
+
+    bool wide_index() const { return pool_size * pool_size > 256; }
+
+    // Floats de la arena que ocupan los indices de 'outputs' ventanas
+    size_t argmax_floats(size_t outputs) const
+    {
+        const size_t bytes = outputs * (wide_index() ? sizeof(uint16_t) : sizeof(uint8_t));
+        return (bytes + sizeof(float) - 1) / sizeof(float);
+    }
+
+    // Pooling de todo el batch; con 'argmax' (uno por salida) guarda la posicion ganadora
+    template <typename Index>
+    TensorView pool(ConstTensorView input, Workspace &ws, Index *argmax_out) const
+    {
+        require_contiguous(input, "Pooling2D");
+        const Shape out_shape = output_shape(input.shape);
 
         size_t batch = input.shape[0];
         size_t channels = input.shape[1];
         size_t in_height = input.shape[2];
         size_t in_width = input.shape[3];
+        size_t out_height = out_shape[2];
+        size_t out_width = out_shape[3];
 
-        size_t out_height = (in_height - pool_size) / stride + 1;
-        size_t out_width = (in_width - pool_size) / stride + 1;
-
-        Tensor output({batch, channels, out_height, out_width});
+        TensorView output = ws.tensor(this, OUTPUT, out_shape);
 
+        // Cada par (muestra, canal) es independiente
+        #pragma omp parallel for collapse(2)
         for (size_t b = 0; b < batch; ++b)
         {
             for (size_t c = 0; c < channels; ++c)
             {
-                for (size_t oh = 0; oh < out_height; ++oh)
+                const size_t plane = b * channels + c;
+                pool_rows(input.data + plane * in_height * in_width, 0, in_height, in_width,
+                          0, out_height, output.data + plane * out_height * out_width, out_width,
+                          argmax_out ? argmax_out + plane * out_height * out_width : nullptr);
+            }
+        }
+
+        return output;
+    }
+
+    template <typename Index>
+    void pool_rows(const float *rows, size_t first_row, size_t in_height, size_t in_width,
+                   size_t row_begin, size_t row_end, float *out, size_t out_width, Index *argmax_out) const
+    {
+        for (size_t oh = row_begin; oh < row_end; ++oh)
+        {
+            for (size_t ow = 0; ow < out_width; ++ow)
+            {
+                float result;
+                if (type == PoolingType::MAX)
+                    result = -std::numeric_limits<float>::infinity();
+                else if (type == PoolingType::MIN)
+                    result = std::numeric_limits<float>::infinity();
+                else
+                    result = 0.0f;
+                size_t best = 0; // Primera posicion con el maximo / minimo
+
+                for (size_t ph = 0; ph < pool_size; ++ph)
                 {
-                    for (size_t ow = 0; ow < out_width; ++ow)
+                    for (size_t pw = 0; pw < pool_size; ++pw)
                     {
-                        float result;
-                        if (type == PoolingType::MAX)
-                            result = -std::numeric_limits<float>::infinity();
-                        else if (type == PoolingType::MIN)
-                            result = std::numeric_limits<float>::infinity();
-                        else
-                            result = 0.0f;
-
-                        for (size_t ph = 0; ph < pool_size; ++ph)
+                        size_t ih = oh * stride + ph;
+                        size_t iw = ow * stride + pw;
+
+                        if (ih >= in_height || iw >= in_width)
+                            continue;
+                        float val = rows[(ih - first_row) * in_width + iw];
+
+                        if (type == PoolingType::AVERAGE)
                         {
-                            for (size_t pw = 0; pw < pool_size; ++pw)
-                            {
-                                size_t ih = oh * stride + ph;
-                                size_t iw = ow * stride + pw;
-
-                                if (ih >= in_height || iw >= in_width)
-                                    continue;
-                                size_t idx = b * channels * in_height * in_width +
-                                             c * in_height * in_width +
-                                             ih * in_width + iw;
-
-                                float val = input.data[idx];
-
-                                if (type == PoolingType::MAX)
-                                    result = std::max(result, val);
-                                else if (type == PoolingType::MIN)
-                                    result = std::min(result, val);
-                                else
-                                    result += val;
-                            }
+                            result += val;
                         }
+                        else if (type == PoolingType::MAX ? val > result : val < result)
+                        {
+                            result = val;
+                            best = ph * pool_size + pw;
+                        }
+                    }
+                }
 
-                        if (type == PoolingType::AVERAGE)
-                            result /= (pool_size * pool_size);
+                if (type == PoolingType::AVERAGE)
+                    result /= (pool_size * pool_size);
+
+                const size_t idx = (oh - row_begin) * out_width + ow;
+                out[idx] = result;
+                if (argmax_out)
+                    argmax_out[idx] = static_cast<Index>(best);
+            }
+        }
+    }
 
-                        size_t out_idx = b * channels * out_height * out_width +
-                                         c * out_height * out_width +
-                                         oh * out_width + ow;
+    // Un solo recorrido de las salidas: cada gradiente va a la posicion guardada de su ventana.
+    // Las ventanas de cada (muestra, canal) solo escriben en su propio plano de grad_input
+    template <typename Index>
+    void scatter(ConstTensorView grad_output, TensorView grad_input, const Index *positions) const
+    {
+        const size_t planes = input_shape[0] * input_shape[1];
+        const size_t in_height = input_shape[2], in_width = input_shape[3];
+        const size_t out_height = grad_output.shape[2], out_width = grad_output.shape[3];
 
-                        output.data[out_idx] = result;
-                    }
+        #pragma omp parallel for
+        for (size_t plane = 0; plane < planes; ++plane)
+        {
+            float *dst = grad_input.data + plane * in_height * in_width;
+            const float *grad = grad_output.data + plane * out_height * out_width;
+            const Index *pos = positions + plane * out_height * out_width;
+            for (size_t oh = 0; oh < out_height; ++oh)
+            {
+                for (size_t ow = 0; ow < out_width; ++ow)
+                {
+                    const size_t o = oh * out_width + ow;
+                    const size_t ih = oh * stride + pos[o] / pool_size;
+                    const size_t iw = ow * stride + pos[o] % pool_size;
+                    dst[ih * in_width + iw] += grad[o];
                 }
             }
         }
-
-        return output;
     }
 
-    Tensor backward(const Tensor &grad_output) override
+    // AVERAGE: cada posicion de la ventana recibe grad / (pool_size * pool_size)
+    void spread_average(ConstTensorView grad_output, TensorView grad_input) const
     {
-        Tensor grad_input(last_input.shape);
-        grad_input.fill(0.0f);
-
-        size_t batch = last_input.shape[0];
-        size_t channels = last_input.shape[1];
-        size_t in_height = last_input.shape[2];
-        size_t in_width = last_input.shape[3];
-        size_t out_height = grad_output.shape[2];
-        size_t out_width = grad_output.shape[3];
+        const size_t planes = input_shape[0] * input_shape[1];
+        const size_t in_height = input_shape[2], in_width = input_shape[3];
+        const size_t out_height = grad_output.shape[2], out_width = grad_output.shape[3];
+        const float scale = 1.0f / (pool_size * pool_size);
 
-        for (size_t b = 0; b < batch; ++b)
+        #pragma omp parallel for
+        for (size_t plane = 0; plane < planes; ++plane)
         {
-            for (size_t c = 0; c < channels; ++c)
+            float *dst = grad_input.data + plane * in_height * in_width;
+            const float *grad = grad_output.data + plane * out_height * out_width;
+            for (size_t oh = 0; oh < out_height; ++oh)
             {
-                for (size_t oh = 0; oh < out_height; ++oh)
+                for (size_t ow = 0; ow < out_width; ++ow)
                 {
-                    for (size_t ow = 0; ow < out_width; ++ow)
+                    const float g = grad[oh * out_width + ow] * scale;
+                    for (size_t ph = 0; ph < pool_size; ++ph)
                     {
-                        size_t out_idx = b * channels * out_height * out_width +
-                                         c * out_height * out_width +
-                                         oh * out_width + ow;
-
-                        float grad = grad_output.data[out_idx];
-
-                        size_t max_ih = 0, max_iw = 0;
-                        float best_val = (type == PoolingType::MIN)
-                                             ? std::numeric_limits<float>::infinity()
-                                             : -std::numeric_limits<float>::infinity();
-
-                        for (size_t ph = 0; ph < pool_size; ++ph)
+                        float *row = dst + (oh * stride + ph) * in_width + ow * stride;
+                        for (size_t pw = 0; pw < pool_size; ++pw)
                         {
-                            for (size_t pw = 0; pw < pool_size; ++pw)
-                            {
-                                size_t ih = oh * stride + ph;
-                                size_t iw = ow * stride + pw;
-
-                                if (ih >= in_height || iw >= in_width)
-                                    continue;
-                                size_t in_idx = b * channels * in_height * in_width +
-                                                c * in_height * in_width +
-                                                ih * in_width + iw;
-
-                                float val = last_input.data[in_idx];
-
-                                if (type == PoolingType::MAX && val > best_val)
-                                {
-                                    best_val = val;
-                                    max_ih = ih;
-                                    max_iw = iw;
-                                }
-                                else if (type == PoolingType::MIN && val < best_val)
-                                {
-                                    best_val = val;
-                                    max_ih = ih;
-                                    max_iw = iw;
-                                }
-                            }
-                        }
-
-                        for (size_t ph = 0; ph < pool_size; ++ph)
-                        {
-                            for (size_t pw = 0; pw < pool_size; ++pw)
-                            {
-                                size_t ih = oh * stride + ph;
-                                size_t iw = ow * stride + pw;
-                                size_t in_idx = b * channels * in_height * in_width +
-                                                c * in_height * in_width +
-                                                ih * in_width + iw;
-
-                                if (type == PoolingType::AVERAGE)
-                                {
-                                    grad_input.data[in_idx] += grad / (pool_size * pool_size);
-                                }
-                                else if (ih == max_ih && iw == max_iw)
-                                {
-                                    grad_input.data[in_idx] += grad;
-                                }
-                            }
+                            row[pw] += g;
                         }
                     }
                 }
             }
         }
-
-        return grad_input;
     }
-
-    void update_parameters(Optimizer &) override {}
-    void zero_grad() override {}
 };
@@ -0,0 +1,399 @@
+#pragma once
+
+#include "Conv2D.hpp"
+#include "Dense.hpp"
+#include "Layer.hpp"
+#include "Math.hpp"
+#include "Simd.hpp"
+#include "Threads.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+// Cuantizacion int8 post-entrenamiento (solo inferencia):
+// - pesos int8 simetricos por canal de salida:  w[oc][k] ~ scales[oc] * q[oc][k], q en [-127, 127]
+// - activaciones de entrada asimetricas por capa: x ~ scale * (q - zero_point), q en [0, 127]
+//   (calibradas con NeuralNetwork::quantize). 7 bits en vez de 8: con maddubs la suma de
+//   dos productos u8 * s8 no satura int16 y VNNI, AVX2 y escalar dan el mismo resultado
+// - productos acumulados en int32 (simd::kernels().gemv_u8s8) y salida en fp32:
+//   y[oc] = scale * scales[oc] * (acc - zero_point * sum_k q[oc][k]) + bias[oc]
+
+// Parametros de cuantizacion de una activacion
+struct ActivationQuant {
+    float scale = 1.0f;
+    int32_t zero_point = 0;
+
+    static constexpr int32_t LEVELS = 127;
+
+    // Rango observado en la calibracion (se amplia para incluir el 0, que debe ser
+    // exacto: es el valor del padding)
+    static ActivationQuant from_range(float lo, float hi) {
+        lo = std::min(lo, 0.0f);
+        hi = std::max(hi, 0.0f);
+        ActivationQuant q;
+        q.scale = (hi > lo) ? (hi - lo) / LEVELS : 1.0f;
+        q.zero_point = std::min<int32_t>(LEVELS, static_cast<int32_t>(std::lround(-lo / q.scale)));
+        return q;
+    }
+
+    // q = clamp(round(x / scale) + zero_point, 0, 127)
+    void quantize(const float* x, uint8_t* q, size_t n) const {
+        const float inv = 1.0f / scale;
+        const float offset = static_cast<float>(zero_point) + 0.5f;
+        for (size_t i = 0; i < n; ++i) {
+            float v = std::min(std::max(x[i] * inv + offset, 0.0f), LEVELS + 0.5f);
+            q[i] = static_cast<uint8_t>(v); // Trunca: v >= 0, asi que redondea
+        }
+    }
+};
+
+// Matriz de pesos int8 [rows, cols] por filas (una por canal de salida), cada fila
+// rellena con ceros hasta 'stride' bytes para que los kernels lean bloques completos
+struct Int8Matrix {
+    static constexpr size_t ROW_ALIGNMENT = 32;
+
+    size_t rows = 0, cols = 0, stride = 0;
+    simd::aligned_vector<int8_t> data; // [rows, stride]
+    vector<float> scales;              // Escala de cada fila
+    vector<int32_t> row_sums;          // sum_k q[r][k] (correccion del zero point)
+
+    Int8Matrix() = default;
+    Int8Matrix(size_t rows_, size_t cols_)
+        : rows(rows_), cols(cols_), stride((cols_ + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT),
+          data(rows_ * stride, 0), scales(rows_, 1.0f), row_sums(rows_, 0) {}
+
+    const int8_t* row(size_t r) const { return data.data() + r * stride; }
+
+    // Cuantiza w[r * row_step + k * col_step] con la escala max|w| / 127 de cada fila
+    void quantize(const float* w, size_t row_step, size_t col_step) {
+        for (size_t r = 0; r < rows; ++r) {
+            float max_abs = 0.0f;
+            for (size_t k = 0; k < cols; ++k) {
+                max_abs = std::max(max_abs, std::fabs(w[r * row_step + k * col_step]));
+            }
+            scales[r] = (max_abs > 0.0f) ? max_abs / 127.0f : 1.0f;
+            const float inv = 1.0f / scales[r];
+            int8_t* q = data.data() + r * stride;
+            for (size_t k = 0; k < cols; ++k) {
+                q[k] = static_cast<int8_t>(std::lround(w[r * row_step + k * col_step] * inv));
+            }
+        }
+        update_row_sums();
+    }
+
+    void update_row_sums() {
+        for (size_t r = 0; r < rows; ++r) {
+            int32_t sum = 0;
+            for (size_t k = 0; k < cols; ++k) {
+                sum += row(r)[k];
+            }
+            row_sums[r] = sum;
+        }
+    }
+
+    // Pesos y escalas como buffers de la capa (se guardan con el modelo)
+    void collect_buffers(vector<LayerBuffer>& buffers) {
+        buffers.push_back({DType::INT8, {rows, stride}, data.data(), data.size()});
+        buffers.push_back({DType::FLOAT32, {rows}, scales.data(), scales.size() * sizeof(float)});
+    }
+
+    size_t bytes() const { return data.size() + scales.size() * sizeof(float); }
+};
+
+// Buffer de 'bytes' bytes en la arena (que reparte floats)
+inline uint8_t* allocate_bytes(Workspace& ws, const void* owner, int slot, size_t bytes) {
+    return reinterpret_cast<uint8_t*>(ws.allocate(owner, slot, (bytes + sizeof(float) - 1) / sizeof(float)));
+}
+
+// Capa densa int8 (creada por NeuralNetwork::quantize a partir de una Dense)
+class QuantizedDense : public Layer {
+public:
+    size_t input_dim;
+    size_t output_dim;
+    Activation activation;
+    ActivationQuant input_quant; // Cuantizacion de la entrada (calibrada)
+    Int8Matrix weights;          // [output_dim, input_dim]: fila oc = columna oc de Dense::weights
+    vector<float> bias;
+
+    QuantizedDense(size_t input_dim_, size_t output_dim_, Activation activation_, ActivationQuant input_quant_)
+        : input_dim(input_dim_), output_dim(output_dim_), activation(activation_), input_quant(input_quant_),
+          weights(output_dim_, input_dim_), bias(output_dim_, 0.0f) {
+        parameters_updated();
+    }
+
+    QuantizedDense(const Dense& dense, ActivationQuant input_quant_)
+        : QuantizedDense(dense.input_dim, dense.output_dim, dense.activation, input_quant_) {
+        Tensor values = dense.weights;
+        values.set_dtype(DType::FLOAT32); // Pesos en 16 bits: se cuantizan sus valores
+        weights.quantize(values.data.data(), 1, output_dim); // Dense guarda [in, out]
+        std::copy(dense.bias.data.begin(), dense.bias.data.end(), bias.begin());
+        parameters_updated();
+    }
+
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<QuantizedDense>(*this); }
+
+    void save(std::ostream& out) const override {
+        out << "QuantizedDense " << input_dim << " " << output_dim << " " << activation_name(activation)
+            << " " << std::setprecision(9) << input_quant.scale << " " << input_quant.zero_point << "\n";
+    }
+
+    void collect_buffers(vector<LayerBuffer>& buffers) override {
+        weights.collect_buffers(buffers);
+        buffers.push_back({DType::FLOAT32, {output_dim}, bias.data(), bias.size() * sizeof(float)});
+    }
+
+    // y = acc * output_scale[oc] + output_offset[oc] (escalas y zero point combinados)
+    void parameters_updated() override {
+        weights.update_row_sums();
+        output_scale.resize(output_dim);
+        output_offset.resize(output_dim);
+        for (size_t oc = 0; oc < output_dim; ++oc) {
+            output_scale[oc] = input_quant.scale * weights.scales[oc];
+            output_offset[oc] = bias[oc] - output_scale[oc] * input_quant.zero_point * weights.row_sums[oc];
+        }
+    }
+
+    Shape output_shape(const Shape& input_shape) const override {
+        const size_t batch = (input_shape.size() == 1) ? 1 : input_shape[0];
+        if (input_shape.empty() || batch == 0 || input_shape.numel() != batch * input_dim) {
+            std::ostringstream msg;
+            msg << "QuantizedDense: se esperaban " << input_dim << " valores por muestra y la entrada es " << input_shape;
+            throw std::invalid_argument(msg.str());
+        }
+        return (input_shape.size() == 1) ? Shape{output_dim} : Shape{batch, output_dim};
+    }
+
+    void buffer_requests(const Shape& input_shape, vector<BufferRequest>& requests) const override {
+        const Shape out = output_shape(input_shape);
+        const size_t rows = input_shape.numel() / input_dim;
+        requests.push_back({INPUT_Q, (rows * weights.stride + 3) / 4, BufferUse::FORWARD_SCRATCH});
+        requests.push_back({ACCUMULATORS, out.numel(), BufferUse::FORWARD_SCRATCH});
+        requests.push_back({OUTPUT, out.numel(), BufferUse::OUTPUT});
+    }
+
+    ConstTensorView forward(ConstTensorView input) override { return infer(input, forward_workspace()); }
+
+    ConstTensorView infer(ConstTensorView input, Workspace& ws) const override {
+        require_contiguous(input, "QuantizedDense");
+        const Shape out_shape = output_shape(input.shape);
+        const size_t rows = input.get_size() / input_dim;
+        const size_t stride = weights.stride;
+
+        // Entrada cuantizada por filas (relleno en cero, igual que los pesos)
+        uint8_t* xq = allocate_bytes(ws, this, INPUT_Q, rows * stride);
+        int32_t* acc = reinterpret_cast<int32_t*>(ws.allocate(this, ACCUMULATORS, rows * output_dim));
+        TensorView output = ws.tensor(this, OUTPUT, out_shape);
+        const auto gemv = simd::kernels().gemv_u8s8;
+        // En paralelo si hay al menos una fila por hilo
+        #pragma omp parallel for if(batch_threads(rows) > 1) schedule(static)
+        for (size_t n = 0; n < rows; ++n) {
+            uint8_t* x = xq + n * stride;
+            input_quant.quantize(input.data + n * input_dim, x, input_dim);
+            std::fill(x + input_dim, x + stride, uint8_t(0));
+            int32_t* a = acc + n * output_dim;
+            gemv(x, weights.data.data(), output_dim, stride, stride, a);
+            float* y = output.data + n * output_dim;
+            for (size_t oc = 0; oc < output_dim; ++oc) {
+                y[oc] = static_cast<float>(a[oc]) * output_scale[oc] + output_offset[oc];
+            }
+        }
+        apply_activation(activation, output.data, output.data, rows, output_dim);
+        return output;
+    }
+
+    ConstTensorView backward(ConstTensorView grad_output) override {
+        (void)grad_output;
+        throw std::runtime_error("QuantizedDense: capa cuantizada, solo inferencia");
+    }
+
+    void zero_grad() override {}
+
+private:
+    enum Buffer { INPUT_Q, ACCUMULATORS, OUTPUT };
+    vector<float> output_scale, output_offset;
+};
+
+// Convolucion int8 (creada por NeuralNetwork::quantize a partir de una Conv2D):
+// cada muestra se cuantiza, se desenrolla en filas de parches [pixeles, patch] (el
+// padding vale zero_point, es decir 0.0) y cada salida es un producto punto int8
+class QuantizedConv2D : public Layer {
+public:
+    size_t input_channels;
+    size_t output_channels;
+    size_t kernel_size;
+    size_t stride;
+    size_t padding;
+    Activation activation; // La de la Conv2D original
+    ActivationQuant input_quant;
+    Int8Matrix kernels; // [output_channels, input_channels * kernel_size * kernel_size]
+    vector<float> bias;
+
+    QuantizedConv2D(size_t in_channels, size_t out_channels, size_t kernel_size_, size_t stride_, size_t padding_,
+                    Activation activation_, ActivationQuant input_quant_)
+        : input_channels(in_channels), output_channels(out_channels), kernel_size(kernel_size_), stride(stride_),
+          padding(padding_), activation(activation_), input_quant(input_quant_),
+          kernels(out_channels, in_channels * kernel_size_ * kernel_size_), bias(out_channels, 0.0f) {
+        parameters_updated();
+    }
+
+    QuantizedConv2D(const Conv2D& conv, ActivationQuant input_quant_)
+        : QuantizedConv2D(conv.input_channels, conv.output_channels, conv.kernel_size, conv.stride, conv.padding,
+                          conv.activation, input_quant_) {
+        Tensor values = conv.kernels;
+        values.set_dtype(DType::FLOAT32);
+        kernels.quantize(values.data.data(), kernels.cols, 1); // Conv2D guarda [oc, patch]
+        std::copy(conv.bias.data.begin(), conv.bias.data.end(), bias.begin());
+        parameters_updated();
+    }
+
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<QuantizedConv2D>(*this); }
+
+    void save(std::ostream& out) const override {
+        out << "QuantizedConv2D " << input_channels << " " << output_channels << " " << kernel_size << " " << stride
+            << " " << padding << " " << std::setprecision(9) << input_quant.scale << " " << input_quant.zero_point;
+        if (activation != Activation::LINEAR) out << " " << activation_name(activation);
+        out << "\n";
+    }
+
+    void collect_buffers(vector<LayerBuffer>& buffers) override {
+        kernels.collect_buffers(buffers);
+        buffers.push_back({DType::FLOAT32, {output_channels}, bias.data(), bias.size() * sizeof(float)});
+    }
+
+    void parameters_updated() override {
+        kernels.update_row_sums();
+        output_scale.resize(output_channels);
+        output_offset.resize(output_channels);
+        for (size_t oc = 0; oc < output_channels; ++oc) {
+            output_scale[oc] = input_quant.scale * kernels.scales[oc];
+            output_offset[oc] = bias[oc] - output_scale[oc] * input_quant.zero_point * kernels.row_sums[oc];
+        }
+    }
+
+    Shape output_shape(const Shape& input_shape) const override {
+        if (input_shape.size() != 4 || input_shape[1] != input_channels) {
+            std::ostringstream msg;
+            msg << "QuantizedConv2D: se esperaba una entrada [batch, " << input_channels << ", height, width] y es "
+                << input_shape;
+            throw std::invalid_argument(msg.str());
+        }
+        if (input_shape[2] + 2 * padding < kernel_size || input_shape[3] + 2 * padding < kernel_size) {
+            throw std::invalid_argument("QuantizedConv2D: la imagen es mas pequeña que el kernel");
+        }
+        return {input_shape[0], output_channels, (input_shape[2] + 2 * padding - kernel_size) / stride + 1,
+                (input_shape[3] + 2 * padding - kernel_size) / stride + 1};
+    }
+
+    void buffer_requests(const Shape& input_shape, vector<BufferRequest>& requests) const override {
+        const Shape out = output_shape(input_shape);
+        const size_t threads = batch_threads(input_shape[0]);
+        const size_t image = input_shape.numel() / input_shape[0];
+        requests.push_back({OUTPUT, out.numel(), BufferUse::OUTPUT});
+        requests.push_back({IMAGE_Q, (threads * image + 3) / 4, BufferUse::FORWARD_SCRATCH});
+        requests.push_back({COLUMNS, threads * out[2] * out[3] * ((kernels.cols + 3) / 4), BufferUse::FORWARD_SCRATCH});
+        requests.push_back({ACCUMULATORS, threads * output_channels * out[2] * out[3], BufferUse::FORWARD_SCRATCH});
+    }
+
+    ConstTensorView forward(ConstTensorView input) override { return infer(input, forward_workspace()); }
+
+    ConstTensorView infer(ConstTensorView input, Workspace& ws) const override {
+        require_contiguous(input, "QuantizedConv2D");
+        const Shape out_shape = output_shape(input.shape);
+        const size_t batch_size = input.shape[0];
+        const size_t height = input.shape[2], width = input.shape[3];
+        const size_t out_height = out_shape[2], out_width = out_shape[3];
+        const size_t pixels = out_height * out_width;
+        const size_t image_size = input_channels * height * width;
+        const size_t groups = (kernels.cols + 3) / 4; // Bytes de cada parche en grupos de 4
+
+        TensorView output = ws.tensor(this, OUTPUT, out_shape);
+        const int threads = batch_threads(batch_size);
+        uint8_t* images = allocate_bytes(ws, this, IMAGE_Q, threads * image_size);
+        uint8_t* columns = allocate_bytes(ws, this, COLUMNS, threads * groups * pixels * 4);
+        int32_t* accumulators =
+            reinterpret_cast<int32_t*>(ws.allocate(this, ACCUMULATORS, threads * output_channels * pixels));
+        const auto gemm = simd::kernels().gemm_s8u8;
+
+        #pragma omp parallel for if(threads > 1) num_threads(threads) schedule(static)
+        for (size_t b = 0; b < batch_size; ++b) {
+            const int tid = thread_index();
+            uint8_t* image = images + tid * image_size;
+            uint8_t* cols = columns + tid * groups * pixels * 4;
+            int32_t* acc = accumulators + tid * output_channels * pixels; // [canales, pixeles]
+            input_quant.quantize(input.data + b * image_size, image, image_size);
+            im2col(image, height, width, out_height, out_width, cols);
+            gemm(kernels.data.data(), kernels.stride, cols, output_channels, pixels, groups, acc);
+
+            float* out = output.data + b * output_channels * pixels;
+            for (size_t oc = 0; oc < output_channels; ++oc) {
+                const float scale = output_scale[oc], offset = output_offset[oc];
+                for (size_t p = 0; p < pixels; ++p) {
+                    out[oc * pixels + p] = static_cast<float>(acc[oc * pixels + p]) * scale + offset;
+                }
+            }
+            apply_activation(activation, out, out, 1, output_channels * pixels);
+        }
+        return output;
+    }
+
+    ConstTensorView backward(ConstTensorView grad_output) override {
+        (void)grad_output;
+        throw std::runtime_error("QuantizedConv2D: capa cuantizada, solo inferencia");
+    }
+
+    void zero_grad() override {}
+
+private:
+    enum Buffer { OUTPUT, IMAGE_Q, COLUMNS, ACCUMULATORS };
+    vector<float> output_scale, output_offset;
+
+    // Parches de la imagen cuantizada [C, H, W] empaquetados para gemm_s8u8: el byte k
+    // (orden (c, kh, kw) de los pesos) del parche de la salida p va en cols[k / 4][p][k % 4]
+    void im2col(const uint8_t* image, size_t height, size_t width, size_t out_height, size_t out_width,
+                uint8_t* cols) const {
+        const size_t pixels = out_height * out_width;
+        const size_t step = stride, pad_size = padding, kernel = kernel_size; // Copias: dst puede alias de *this
+        const uint8_t pad = static_cast<uint8_t>(input_quant.zero_point);
+        size_t k = 0;
+        for (size_t c = 0; c < input_channels; ++c) {
+            const uint8_t* plane = image + c * height * width;
+            for (size_t kh = 0; kh < kernel; ++kh) {
+                for (size_t kw = 0; kw < kernel; ++kw, ++k) {
+                    uint8_t* dst = cols + (k / 4) * pixels * 4 + k % 4;
+                    // Salidas ow cuya columna iw = ow * step + kw - pad_size cae en la imagen
+                    const size_t ow_begin = std::min(out_width, (pad_size > kw ? pad_size - kw + step - 1 : 0) / step);
+                    const size_t ow_end =
+                        std::max(ow_begin, std::min(out_width, (width + pad_size - kw + step - 1) / step));
+                    for (size_t oh = 0; oh < out_height; ++oh, dst += out_width * 4) {
+                        const long ih = static_cast<long>(oh * step + kh) - static_cast<long>(pad_size);
+                        if (ih < 0 || ih >= static_cast<long>(height)) {
+                            for (size_t ow = 0; ow < out_width; ++ow) {
+                                dst[ow * 4] = pad;
+                            }
+                            continue;
+                        }
+                        const uint8_t* src = plane + ih * width;
+                        for (size_t ow = 0; ow < ow_begin; ++ow) {
+                            dst[ow * 4] = pad;
+                        }
+                        for (size_t ow = ow_begin; ow < ow_end; ++ow) {
+                            dst[ow * 4] = src[ow * step + kw - pad_size];
+                        }
+                        for (size_t ow = ow_end; ow < out_width; ++ow) {
+                            dst[ow * 4] = pad;
+                        }
+                    }
+                }
+            }
+        }
+        for (; k % 4 != 0; ++k) { // Relleno del ultimo grupo (pesos nulos)
+            uint8_t* dst = cols + (k / 4) * pixels * 4 + k % 4;
+            for (size_t p = 0; p < pixels; ++p) {
+                dst[p * 4] = 0;
+            }
+        }
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// Forma (o pasos) de un tensor guardada en linea, sin memoria dinamica.
+// Rango maximo MAX_RANK; se comporta como un vector<size_t> pequeño.
+class Shape {
+public:
+    static constexpr size_t MAX_RANK = 6;
+
+    using value_type = size_t;
+    using iterator = size_t *;
+    using const_iterator = const size_t *;
+
+    Shape() {}
+
+    Shape(initializer_list<size_t> dims) { assign(dims.begin(), dims.end()); }
+
+    Shape(const vector<size_t> &dims) { assign(dims.begin(), dims.end()); }
+
+    template <typename It, typename = enable_if_t<!is_integral<It>::value>>
+    Shape(It first, It last) { assign(first, last); }
+
+    template <typename It>
+    void assign(It first, It last) {
+        rank = 0;
+        for (; first != last; ++first) {
+            push_back(static_cast<size_t>(*first));
+        }
+    }
+
+    size_t size() const { return rank; }
+    bool empty() const { return rank == 0; }
+
+    size_t &operator[](size_t i) { return dims[i]; }
+    const size_t &operator[](size_t i) const { return dims[i]; }
+
+    size_t &front() { return dims[0]; }
+    const size_t &front() const { return dims[0]; }
+    size_t &back() { return dims[rank - 1]; }
+    const size_t &back() const { return dims[rank - 1]; }
+
+    iterator begin() { return dims; }
+    iterator end() { return dims + rank; }
+    const_iterator begin() const { return dims; }
+    const_iterator end() const { return dims + rank; }
+
+    void push_back(size_t dim) {
+        if (rank == MAX_RANK) {
+            throw std::invalid_argument("Shape: se supera el rango maximo de " + to_string(MAX_RANK));
+        }
+        dims[rank++] = dim;
+    }
+
+    void resize(size_t new_rank, size_t value = 0) {
+        if (new_rank > MAX_RANK) {
+            throw std::invalid_argument("Shape: se supera el rango maximo de " + to_string(MAX_RANK));
+        }
+        for (size_t i = rank; i < new_rank; ++i) {
+            dims[i] = value;
+        }
+        rank = static_cast<unsigned char>(new_rank);
+    }
+
+    void clear() { rank = 0; }
+
+    // Producto de las dimensiones (numero de elementos)
+    size_t numel() const {
+        size_t total = 1;
+        for (size_t i = 0; i < rank; ++i) {
+            total *= dims[i];
+        }
+        return total;
+    }
+
+    operator vector<size_t>() const { return vector<size_t>(begin(), end()); }
+
+    friend bool operator==(const Shape &a, const Shape &b) {
+        if (a.rank != b.rank) return false;
+        for (size_t i = 0; i < a.rank; ++i) {
+            if (a.dims[i] != b.dims[i]) return false;
+        }
+        return true;
+    }
+
+    friend bool operator!=(const Shape &a, const Shape &b) { return !(a == b); }
+
+    friend ostream &operator<<(ostream &os, const Shape &shape) {
+        os << "[";
+        for (size_t i = 0; i < shape.rank; ++i) {
+            os << shape.dims[i];
+            if (i + 1 < shape.rank) {
+                os << ", ";
+            }
+        }
+        os << "]";
+        return os;
+    }
+
+private:
+    size_t dims[MAX_RANK] = {};
+    unsigned char rank = 0;
+};
@@ -0,0 +1,640 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(__clang__)
+#define CNN_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define CNN_SIMD_X86 0
+#endif
+
+// Kernels vectoriales con seleccion en tiempo de ejecucion:
+// AVX-512 (VNNI para int8) -> AVX2/FMA -> SSE2 -> escalar.
+// Cada conjunto de instrucciones se compila en su propio bloque '#pragma GCC target',
+// de modo que un solo binario (compilado sin -march) usa lo mejor que tenga la CPU.
+// La variable de entorno CNN_SIMD=scalar|sse|avx2|avx512|vnni limita el nivel elegido.
+namespace simd {
+
+// Alineacion de los buffers propios (una linea de cache, un registro AVX-512)
+constexpr size_t ALIGNMENT = 64;
+
+// Allocator alineado a ALIGNMENT para std::vector
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT)));
+    }
+    void deallocate(T *p, size_t) { ::operator delete(p, std::align_val_t(ALIGNMENT)); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U> &) const { return false; }
+};
+
+template <typename T>
+using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
+// Redondea n elementos float hacia arriba a un multiplo de ALIGNMENT bytes
+constexpr size_t align_floats(size_t n) {
+    constexpr size_t per_line = ALIGNMENT / sizeof(float);
+    return (n + per_line - 1) / per_line * per_line;
+}
+
+// Tabla de kernels de un conjunto de instrucciones
+struct Kernels {
+    const char *name;
+
+    // Algebra lineal
+    float (*dot)(const float *a, const float *b, size_t n);           // <a, b>
+    void (*axpy)(float alpha, const float *x, float *y, size_t n);    // y += alpha * x
+    void (*mul)(const float *a, const float *b, float *out, size_t n); // out = a * b
+    float (*max_value)(const float *x, size_t n);                     // max(x), n > 0
+
+    // Activaciones (in y out pueden ser el mismo buffer) y sus derivadas: g *= f'(z)
+    void (*relu)(const float *in, float *out, size_t n);
+    void (*relu_grad)(const float *z, float *g, size_t n);
+    void (*sigmoid)(const float *in, float *out, size_t n);
+    void (*sigmoid_grad)(const float *z, float *g, size_t n);
+    void (*tanh)(const float *in, float *out, size_t n);
+    void (*tanh_grad)(const float *z, float *g, size_t n);
+    void (*exp)(const float *in, float *out, size_t n);
+    void (*softmax)(const float *in, float *out, size_t n);
+
+    // Actualizaciones de optimizadores (c1 y c2: correcciones de sesgo 1 / (1 - beta^t))
+    void (*rmsprop_update)(float *param, const float *grad, float *v, size_t n,
+                           float lr, float beta, float eps);
+    void (*adam_update)(float *param, const float *grad, float *m, float *v, size_t n,
+                        float lr, float beta1, float beta2, float c1, float c2, float eps, float weight_decay);
+
+    // Inferencia int8: out[r] = sum_i a[i] * B[r * stride + i] exacto en int32, con a en
+    // [0, 127] (asi la suma de dos productos de maddubs no satura int16 y todas las
+    // variantes dan lo mismo). Las filas se procesan de a cuatro compartiendo 'a'
+    void (*gemv_u8s8)(const uint8_t *a, const int8_t *B, size_t rows, size_t n, size_t stride, int32_t *out);
+    // C[m, n] = sum_k A[m * lda + k] * B[k / 4][n][k % 4] con k < 4 * K4: B empaquetado de a
+    // cuatro bytes por columna, asi cada fila de A se difunde sin sumas horizontales
+    void (*gemm_s8u8)(const int8_t *A, size_t lda, const uint8_t *B, size_t M, size_t N, size_t K4, int32_t *C);
+    const char *int8_name;
+
+    // Valores en 16 bits (BF16 / FP16): conversiones con redondeo al par mas cercano y
+    // y += alpha * x convirtiendo x al cargarlo (acumula en fp32)
+    void (*to_bf16)(const float *in, uint16_t *out, size_t n);
+    void (*from_bf16)(const uint16_t *in, float *out, size_t n);
+    void (*to_fp16)(const float *in, uint16_t *out, size_t n);
+    void (*from_fp16)(const uint16_t *in, float *out, size_t n);
+    void (*axpy_bf16)(float alpha, const uint16_t *x, float *y, size_t n);
+    void (*axpy_fp16)(float alpha, const uint16_t *x, float *y, size_t n);
+};
+
+// Conversiones escalares de referencia; dan los mismos bits que F16C (vcvtps2ph con
+// redondeo al par) y que un desplazamiento de 16 bits para BF16
+inline uint16_t bf16_from_float(float x) {
+    uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    if ((u & 0x7FFFFFFFu) > 0x7F800000u) {
+        return static_cast<uint16_t>((u >> 16) | 0x40); // NaN silencioso
+    }
+    u += 0x7FFFu + ((u >> 16) & 1);
+    return static_cast<uint16_t>(u >> 16);
+}
+
+inline float float_from_bf16(uint16_t h) {
+    const uint32_t u = static_cast<uint32_t>(h) << 16;
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+inline uint16_t fp16_from_float(float x) {
+    uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    const uint32_t sign = (u >> 16) & 0x8000u;
+    u &= 0x7FFFFFFFu;
+    if (u > 0x7F800000u) { // NaN silencioso con los bits altos de la mantisa
+        return static_cast<uint16_t>(sign | 0x7E00u | ((u >> 13) & 0x3FFu));
+    }
+    if (u >= 0x47800000u) { // >= 65536 (e infinito): infinito
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+    if (u < 0x38800000u) { // Subnormal en FP16 (< 2^-14): unidades de 2^-24
+        if (u < 0x33000000u) return static_cast<uint16_t>(sign); // <= 2^-25 redondea a cero
+        const uint32_t mantissa = (u & 0x7FFFFFu) | 0x800000u;
+        const uint32_t shift = 126 - (u >> 23);
+        uint32_t result = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1), half = 1u << (shift - 1);
+        if (rest > half || (rest == half && (result & 1))) ++result;
+        return static_cast<uint16_t>(sign | result);
+    }
+    uint32_t result = (u >> 13) - (112u << 10); // Exponente con sesgo 15 (el acarreo puede llegar a infinito)
+    const uint32_t rest = u & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (result & 1))) ++result;
+    return static_cast<uint16_t>(sign | result);
+}
+
+inline float float_from_fp16(uint16_t h) {
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    const uint32_t exponent = (h >> 10) & 0x1Fu, mantissa = h & 0x3FFu;
+    uint32_t u;
+    if (exponent == 0x1F) { // Infinito o NaN (silencioso, como F16C)
+        u = sign | 0x7F800000u | (mantissa ? 0x400000u | (mantissa << 13) : 0u);
+    } else if (exponent != 0) {
+        u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else {
+        const float value = static_cast<float>(mantissa) * 5.9604644775390625e-8f; // Subnormal: mantisa * 2^-24 (exacto)
+        return sign ? -value : value;
+    }
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+// Implementacion escalar: referencia y cola de los kernels vectoriales.
+// Sus kernels no se integran (noinline) en los bloques AVX: alli GCC contraeria
+// a * b + c en FMA segun el contexto y el resultado dependeria del llamador.
+#define CNN_SIMD_KERNEL __attribute__((noinline))
+namespace scalar {
+struct V {
+    using reg = float;
+    static constexpr size_t W = 1;
+    static constexpr const char *name = "scalar";
+
+    static reg load(const float *p) { return *p; }
+    static void store(float *p, reg v) { *p = v; }
+    static reg set1(float x) { return x; }
+    static reg zero() { return 0.0f; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg div(reg a, reg b) { return a / b; }
+    static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+    static reg max(reg a, reg b) { return a > b ? a : b; }
+    static reg min(reg a, reg b) { return a < b ? a : b; }
+    static reg sqrt(reg a) { return std::sqrt(a); }
+    static reg round(reg a) { return std::nearbyint(a); }
+    static reg pow2(reg n) {
+        int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+    static reg mask_positive(reg z, reg g) { return z > 0.0f ? g : 0.0f; }
+    static float hsum(reg v) { return v; }
+    static float hmax(reg v) { return v; }
+    static reg load_bf16(const uint16_t *p) { return float_from_bf16(*p); }
+    static reg load_fp16(const uint16_t *p) { return float_from_fp16(*p); }
+    static void store_fp16(uint16_t *p, reg v) { *p = fp16_from_float(v); }
+    static float fp16_to_float(uint16_t h) { return float_from_fp16(h); }
+    static uint16_t float_to_fp16(float x) { return fp16_from_float(x); }
+};
+
+inline int32_t dot_u8s8(const uint8_t *a, const int8_t *b, size_t n) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += static_cast<int32_t>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+inline void gemv_u8s8(const uint8_t *a, const int8_t *B, size_t rows, size_t n, size_t stride, int32_t *out) {
+    for (size_t r = 0; r < rows; ++r) {
+        out[r] = dot_u8s8(a, B + r * stride, n);
+    }
+}
+
+// Columnas [n_begin, n_end) de gemm_s8u8 (tambien cola de las versiones vectoriales)
+inline void gemm_s8u8_columns(const int8_t *A, size_t lda, const uint8_t *B, size_t M, size_t N, size_t K4,
+                              int32_t *C, size_t n_begin, size_t n_end) {
+    for (size_t m = 0; m < M; ++m) {
+        for (size_t n = n_begin; n < n_end; ++n) {
+            int32_t sum = 0;
+            for (size_t k = 0; k < 4 * K4; ++k) {
+                sum += static_cast<int32_t>(B[((k / 4) * N + n) * 4 + k % 4]) * A[m * lda + k];
+            }
+            C[m * N + n] = sum;
+        }
+    }
+}
+
+inline void gemm_s8u8(const int8_t *A, size_t lda, const uint8_t *B, size_t M, size_t N, size_t K4, int32_t *C) {
+    gemm_s8u8_columns(A, lda, B, M, N, K4, C, 0, N);
+}
+constexpr const char *int8_name = "scalar";
+#include "SimdKernels.hpp"
+} // namespace scalar
+#undef CNN_SIMD_KERNEL
+#define CNN_SIMD_KERNEL
+
+#if CNN_SIMD_X86
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+namespace sse {
+struct V {
+    using reg = __m128;
+    static constexpr size_t W = 4;
+    static constexpr const char *name = "sse2";
+
+    static reg load(const float *p) { return _mm_loadu_ps(p); }
+    static void store(float *p, reg v) { _mm_storeu_ps(p, v); }
+    static reg set1(float x) { return _mm_set1_ps(x); }
+    static reg zero() { return _mm_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+    static reg sqrt(reg a) { return _mm_sqrt_ps(a); }
+    static reg round(reg a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+    static reg pow2(reg n) {
+        __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+        return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+    }
+    static reg mask_positive(reg z, reg g) { return _mm_and_ps(_mm_cmpgt_ps(z, _mm_setzero_ps()), g); }
+    static float hsum(reg v) {
+        reg t = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 0x55));
+        return _mm_cvtss_f32(t);
+    }
+    static float hmax(reg v) {
+        reg t = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        t = _mm_max_ss(t, _mm_shuffle_ps(t, t, 0x55));
+        return _mm_cvtss_f32(t);
+    }
+    // BF16: los 16 bits altos de un float. SSE2 no tiene F16C: FP16 de a un valor
+    static reg load_bf16(const uint16_t *p) {
+        const __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+        return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), h));
+    }
+    static reg load_fp16(const uint16_t *p) {
+        return _mm_setr_ps(float_from_fp16(p[0]), float_from_fp16(p[1]), float_from_fp16(p[2]),
+                           float_from_fp16(p[3]));
+    }
+    static void store_fp16(uint16_t *p, reg v) {
+        alignas(16) float values[4];
+        _mm_store_ps(values, v);
+        for (size_t i = 0; i < 4; ++i) p[i] = fp16_from_float(values[i]);
+    }
+    static float fp16_to_float(uint16_t h) { return float_from_fp16(h); }
+    static uint16_t float_to_fp16(float x) { return fp16_from_float(x); }
+};
+
+using scalar::gemv_u8s8; // maddubs es SSSE3
+using scalar::gemm_s8u8;
+using scalar::int8_name;
+#include "SimdKernels.hpp"
+} // namespace sse
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma,f16c")
+namespace avx2 {
+struct V {
+    using reg = __m256;
+    static constexpr size_t W = 8;
+    static constexpr const char *name = "avx2";
+
+    static reg load(const float *p) { return _mm256_loadu_ps(p); }
+    static void store(float *p, reg v) { _mm256_storeu_ps(p, v); }
+    static reg set1(float x) { return _mm256_set1_ps(x); }
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+    static reg sqrt(reg a) { return _mm256_sqrt_ps(a); }
+    static reg round(reg a) { return _mm256_cvtepi32_ps(_mm256_cvtps_epi32(a)); }
+    static reg pow2(reg n) {
+        __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+    }
+    static reg mask_positive(reg z, reg g) {
+        return _mm256_and_ps(_mm256_cmp_ps(z, _mm256_setzero_ps(), _CMP_GT_OQ), g);
+    }
+    static float hsum(reg v) {
+        __m128 t = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        t = _mm_add_ps(t, _mm_movehl_ps(t, t));
+        t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 0x55));
+        return _mm_cvtss_f32(t);
+    }
+    static float hmax(reg v) {
+        __m128 t = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        t = _mm_max_ps(t, _mm_movehl_ps(t, t));
+        t = _mm_max_ss(t, _mm_shuffle_ps(t, t, 0x55));
+        return _mm_cvtss_f32(t);
+    }
+    static reg load_bf16(const uint16_t *p) {
+        const __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(h, 16));
+    }
+    static reg load_fp16(const uint16_t *p) { return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))); }
+    static void store_fp16(uint16_t *p, reg v) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+    // Un valor con F16C (los restos de los kernels de 16 bits)
+    static float fp16_to_float(uint16_t h) { return _cvtsh_ss(h); }
+    static uint16_t float_to_fp16(float x) { return _cvtss_sh(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+};
+
+// Suma horizontal de cuatro acumuladores int32: {sum(a0), sum(a1), sum(a2), sum(a3)}
+inline __m128i hsum4_epi32(__m256i a0, __m256i a1, __m256i a2, __m256i a3) {
+    __m256i s = _mm256_hadd_epi32(_mm256_hadd_epi32(a0, a1), _mm256_hadd_epi32(a2, a3));
+    return _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+}
+
+// maddubs: u8 * s8 y suma de pares en int16; madd con unos: suma de pares en int32
+inline __m256i dot32_u8s8(__m256i acc, __m256i a, const int8_t *b) {
+    __m256i pairs = _mm256_maddubs_epi16(a, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b)));
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+}
+
+inline void gemv_u8s8(const uint8_t *a, const int8_t *B, size_t rows, size_t n, size_t stride, int32_t *out) {
+    const size_t blocks = n / 32 * 32;
+    size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const int8_t *b = B + r * stride;
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        for (size_t i = 0; i < blocks; i += 32) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            acc0 = dot32_u8s8(acc0, x, b + i);
+            acc1 = dot32_u8s8(acc1, x, b + stride + i);
+            acc2 = dot32_u8s8(acc2, x, b + 2 * stride + i);
+            acc3 = dot32_u8s8(acc3, x, b + 3 * stride + i);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + r), hsum4_epi32(acc0, acc1, acc2, acc3));
+        for (size_t k = 0; k < 4 && blocks < n; ++k) {
+            out[r + k] += scalar::dot_u8s8(a + blocks, b + k * stride + blocks, n - blocks);
+        }
+    }
+    scalar::gemv_u8s8(a, B + r * stride, rows - r, n, stride, out + r);
+}
+
+// Cuatro bytes de A (los de una columna empaquetada de B) repetidos en cada lane int32
+inline int32_t load4(const int8_t *p) {
+    int32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline __m256i madd_u8s8(__m256i acc, __m256i x, __m256i w) {
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), _mm256_set1_epi16(1)));
+}
+
+// Bloques de 4 filas x 8 columnas: cada carga de B (8 columnas x 4 bytes) sirve a 4 filas
+inline void gemm_s8u8_columns(const int8_t *A, size_t lda, const uint8_t *B, size_t M, size_t N, size_t K4,
+                              int32_t *C, size_t n_begin, size_t n_end) {
+    size_t n = n_begin;
+    for (; n + 8 <= n_end; n += 8) {
+        size_t m = 0;
+        for (; m + 4 <= M; m += 4) {
+            const int8_t *a = A + m * lda;
+            __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+            for (size_t kb = 0; kb < K4; ++kb) {
+                const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(B + (kb * N + n) * 4));
+                acc0 = madd_u8s8(acc0, x, _mm256_set1_epi32(load4(a + kb * 4)));
+                acc1 = madd_u8s8(acc1, x, _mm256_set1_epi32(load4(a + lda + kb * 4)));
+                acc2 = madd_u8s8(acc2, x, _mm256_set1_epi32(load4(a + 2 * lda + kb * 4)));
+                acc3 = madd_u8s8(acc3, x, _mm256_set1_epi32(load4(a + 3 * lda + kb * 4)));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(C + m * N + n), acc0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(C + (m + 1) * N + n), acc1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(C + (m + 2) * N + n), acc2);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(C + (m + 3) * N + n), acc3);
+        }
+        for (; m < M; ++m) {
+            __m256i acc = _mm256_setzero_si256();
+            for (size_t kb = 0; kb < K4; ++kb) {
+                const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(B + (kb * N + n) * 4));
+                acc = madd_u8s8(acc, x, _mm256_set1_epi32(load4(A + m * lda + kb * 4)));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(C + m * N + n), acc);
+        }
+    }
+    scalar::gemm_s8u8_columns(A, lda, B, M, N, K4, C, n, n_end);
+}
+
+inline void gemm_s8u8(const int8_t *A, size_t lda, const uint8_t *B, size_t M, size_t N, size_t K4, int32_t *C) {
+    gemm_s8u8_columns(A, lda, B, M, N, K4, C, 0, N);
+}
+constexpr const char *int8_name = "avx2";
+#include "SimdKernels.hpp"
+} // namespace avx2
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,f16c")
+// GCC 12 avisa de '__Y' sin inicializar dentro de sus propios intrinsics AVX-512
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+namespace avx512 {
+struct V {
+    using reg = __m512;
+    static constexpr size_t W = 16;
+    static constexpr const char *name = "avx512";
+
+    static reg load(const float *p) { return _mm512_loadu_ps(p); }
+    static void store(float *p, reg v) { _mm512_storeu_ps(p, v); }
+    static reg set1(float x) { return _mm512_set1_ps(x); }
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+    static reg sqrt(reg a) { return _mm512_sqrt_ps(a); }
+    static reg round(reg a) { return _mm512_cvtepi32_ps(_mm512_cvtps_epi32(a)); }
+    static reg pow2(reg n) {
+        __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+    }
+    static reg mask_positive(reg z, reg g) {
+        return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(z, _mm512_setzero_ps(), _CMP_GT_OQ), g);
+    }
+    // Reducciones plegando bloques de 128 bits
+    static float hsum(reg v) {
+        v = _mm512_add_ps(v, _mm512_shuffle_f32x4(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm512_add_ps(v, _mm512_shuffle_f32x4(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128 t = _mm512_castps512_ps128(v);
+        t = _mm_add_ps(t, _mm_movehl_ps(t, t));
+        t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 0x55));
+        return _mm_cvtss_f32(t);
+    }
+    static float hmax(reg v) {
+        v = _mm512_max_ps(v, _mm512_shuffle_f32x4(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm512_max_ps(v, _mm512_shuffle_f32x4(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128 t = _mm512_castps512_ps128(v);
+        t = _mm_max_ps(t, _mm_movehl_ps(t, t));
+        t = _mm_max_ss(t, _mm_shuffle_ps(t, t, 0x55));
+        return _mm_cvtss_f32(t);
+    }
+    static reg load_bf16(const uint16_t *p) {
+        const __m512i h = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(h, 16));
+    }
+    static reg load_fp16(const uint16_t *p) {
+        return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+    }
+    static void store_fp16(uint16_t *p, reg v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+    static float fp16_to_float(uint16_t h) { return _cvtsh_ss(h); }
+    static uint16_t float_to_fp16(float x) { return _cvtss_sh(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+};
+
+using avx2::gemv_u8s8; // Sin VNNI (ver namespace vnni)
+using avx2::gemm_s8u8;
+using avx2::int8_name;
+#include "SimdKernels.hpp"
+} // namespace avx512
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,avx512f,avx512bw,avx512vl,avx512vnni")
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+namespace vnni {
+// vpdpbusd: u8 * s8 sumados de a cuatro directamente en int32 (sin pasos intermedios);
+// bloques de 64 bytes y un ultimo de 32
+inline __m256i fold_epi32(__m512i acc) {
+    return _mm256_add_epi32(_mm512_castsi512_si256(acc), _mm512_extracti64x4_epi64(acc, 1));
+}
+
+inline void gemv_u8s8(const uint8_t *a, const int8_t *B, size_t rows, size_t n, size_t stride, int32_t *out) {
+    const size_t wide = n / 64 * 64, blocks = n / 32 * 32;
+    size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const int8_t *b = B + r * stride;
+        __m512i w0 = _mm512_setzero_si512(), w1 = w0, w2 = w0, w3 = w0;
+        for (size_t i = 0; i < wide; i += 64) {
+            const __m512i x = _mm512_loadu_si512(a + i);
+            w0 = _mm512_dpbusd_epi32(w0, x, _mm512_loadu_si512(b + i));
+            w1 = _mm512_dpbusd_epi32(w1, x, _mm512_loadu_si512(b + stride + i));
+            w2 = _mm512_dpbusd_epi32(w2, x, _mm512_loadu_si512(b + 2 * stride + i));
+            w3 = _mm512_dpbusd_epi32(w3, x, _mm512_loadu_si512(b + 3 * stride + i));
+        }
+        __m256i acc0 = fold_epi32(w0), acc1 = fold_epi32(w1), acc2 = fold_epi32(w2), acc3 = fold_epi32(w3);
+        if (wide < blocks) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + wide));
+            auto load = [&](size_t k) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + k * stride + wide)); };
+            acc0 = _mm256_dpbusd_epi32(acc0, x, load(0));
+            acc1 = _mm256_dpbusd_epi32(acc1, x, load(1));
+            acc2 = _mm256_dpbusd_epi32(acc2, x, load(2));
+            acc3 = _mm256_dpbusd_epi32(acc3, x, load(3));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + r), avx2::hsum4_epi32(acc0, acc1, acc2, acc3));
+        for (size_t k = 0; k < 4 && blocks < n; ++k) {
+            out[r + k] += scalar::dot_u8s8(a + blocks, b + k * stride + blocks, n - blocks);
+        }
+    }
+    scalar::gemv_u8s8(a, B + r * stride, rows - r, n, stride, out + r);
+}
+
+// Bloques de 4 filas x 16 columnas; las columnas restantes con la version AVX2
+inline void gemm_s8u8(const int8_t *A, size_t lda, const uint8_t *B, size_t M, size_t N, size_t K4, int32_t *C) {
+    size_t n = 0;
+    for (; n + 16 <= N; n += 16) {
+        size_t m = 0;
+        for (; m + 4 <= M; m += 4) {
+            const int8_t *a = A + m * lda;
+            __m512i acc0 = _mm512_setzero_si512(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+            for (size_t kb = 0; kb < K4; ++kb) {
+                const __m512i x = _mm512_loadu_si512(B + (kb * N + n) * 4);
+                acc0 = _mm512_dpbusd_epi32(acc0, x, _mm512_set1_epi32(avx2::load4(a + kb * 4)));
+                acc1 = _mm512_dpbusd_epi32(acc1, x, _mm512_set1_epi32(avx2::load4(a + lda + kb * 4)));
+                acc2 = _mm512_dpbusd_epi32(acc2, x, _mm512_set1_epi32(avx2::load4(a + 2 * lda + kb * 4)));
+                acc3 = _mm512_dpbusd_epi32(acc3, x, _mm512_set1_epi32(avx2::load4(a + 3 * lda + kb * 4)));
+            }
+            _mm512_storeu_si512(C + m * N + n, acc0);
+            _mm512_storeu_si512(C + (m + 1) * N + n, acc1);
+            _mm512_storeu_si512(C + (m + 2) * N + n, acc2);
+            _mm512_storeu_si512(C + (m + 3) * N + n, acc3);
+        }
+        for (; m < M; ++m) {
+            __m512i acc = _mm512_setzero_si512();
+            for (size_t kb = 0; kb < K4; ++kb) {
+                acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512(B + (kb * N + n) * 4),
+                                          _mm512_set1_epi32(avx2::load4(A + m * lda + kb * 4)));
+            }
+            _mm512_storeu_si512(C + m * N + n, acc);
+        }
+    }
+    avx2::gemm_s8u8_columns(A, lda, B, M, N, K4, C, n, N);
+}
+} // namespace vnni
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+
+#endif // CNN_SIMD_X86
+
+// Nivel de instrucciones: 0 = escalar, 1 = SSE2, 2 = AVX2/FMA/F16C, 3 = AVX-512,
+// 4 = AVX-512 con VNNI (solo cambia el kernel int8)
+inline int detect_level() {
+    int level = 0;
+#if CNN_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) level = 1;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) level = 2;
+    if (level == 2 && __builtin_cpu_supports("avx512f")) level = 3;
+    // El kernel vnni usa vpdpbusd sobre registros de 256 bits (codificacion AVX512VL)
+    if (level == 3 && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") &&
+        __builtin_cpu_supports("avx512vnni")) {
+        level = 4;
+    }
+#endif
+
+    // Limite opcional desde el entorno (para pruebas o depuracion)
+    if (const char *env = std::getenv("CNN_SIMD")) {
+        std::string pref(env);
+        int limit = (pref == "scalar") ? 0 : (pref == "sse") ? 1 : (pref == "avx2") ? 2 : (pref == "avx512") ? 3 : 4;
+        level = (limit < level) ? limit : level;
+    }
+    return level;
+}
+
+// Kernels del mejor conjunto de instrucciones disponible (se elige una sola vez)
+inline const Kernels &kernels() {
+    static const Kernels selected = []() {
+#if CNN_SIMD_X86
+        switch (detect_level()) {
+        case 4: {
+            Kernels table = avx512::table();
+            table.gemv_u8s8 = vnni::gemv_u8s8;
+            table.gemm_s8u8 = vnni::gemm_s8u8;
+            table.int8_name = "avx512-vnni";
+            return table;
+        }
+        case 3: return avx512::table();
+        case 2: return avx2::table();
+        case 1: return sse::table();
+        default: break;
+        }
+#endif
+        return scalar::table();
+    }();
+    return selected;
+}
+
+} // namespace simd
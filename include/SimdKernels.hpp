@@ -0,0 +1,293 @@
+// Kernels genericos sobre el tipo vectorial 'V' del namespace que lo incluye.
+// Sin '#pragma once': Simd.hpp lo incluye una vez por conjunto de instrucciones,
+// dentro de su bloque '#pragma GCC target'. Los restos que no llenan un vector
+// se procesan con la version escalar (scalar::), asi todas las variantes usan
+// las mismas aproximaciones. CNN_SIMD_KERNEL marca los kernels que sirven de cola.
+
+using reg = V::reg;
+constexpr size_t W = V::W;
+
+// Producto punto con dos acumuladores para ocultar la latencia de FMA
+inline float dot(const float *a, const float *b, size_t n) {
+    reg acc0 = V::zero(), acc1 = V::zero();
+    size_t i = 0;
+    for (; i + 2 * W <= n; i += 2 * W) {
+        acc0 = V::fmadd(V::load(a + i), V::load(b + i), acc0);
+        acc1 = V::fmadd(V::load(a + i + W), V::load(b + i + W), acc1);
+    }
+    for (; i + W <= n; i += W) {
+        acc0 = V::fmadd(V::load(a + i), V::load(b + i), acc0);
+    }
+    float sum = V::hsum(V::add(acc0, acc1));
+    for (; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// y += alpha * x
+inline void axpy(float alpha, const float *x, float *y, size_t n) {
+    const reg a = V::set1(alpha);
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(y + i, V::fmadd(a, V::load(x + i), V::load(y + i)));
+    }
+    for (; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+// out = a * b (elemento a elemento)
+inline void mul(const float *a, const float *b, float *out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(out + i, V::mul(V::load(a + i), V::load(b + i)));
+    }
+    for (; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+inline float max_value(const float *x, size_t n) {
+    size_t i = 0;
+    float result = x[0];
+    if (n >= W) {
+        reg acc = V::load(x);
+        for (i = W; i + W <= n; i += W) {
+            acc = V::max(acc, V::load(x + i));
+        }
+        result = V::hmax(acc);
+    }
+    for (; i < n; ++i) {
+        result = (x[i] > result) ? x[i] : result;
+    }
+    return result;
+}
+
+// exp(x) con reduccion de rango x = n*ln2 + r y polinomio de grado 5 (Cephes, error ~1e-7)
+inline reg exp_reg(reg x) {
+    x = V::min(V::max(x, V::set1(-87.3f)), V::set1(88.0f));
+    reg n = V::round(V::mul(x, V::set1(1.44269504088896341f)));
+    x = V::sub(x, V::mul(n, V::set1(0.693359375f)));
+    x = V::sub(x, V::mul(n, V::set1(-2.12194440e-4f)));
+
+    reg p = V::set1(1.9875691500e-4f);
+    p = V::fmadd(p, x, V::set1(1.3981999507e-3f));
+    p = V::fmadd(p, x, V::set1(8.3334519073e-3f));
+    p = V::fmadd(p, x, V::set1(4.1665795894e-2f));
+    p = V::fmadd(p, x, V::set1(1.6666665459e-1f));
+    p = V::fmadd(p, x, V::set1(5.0000001201e-1f));
+    p = V::fmadd(p, V::mul(x, x), V::add(x, V::set1(1.0f)));
+    return V::mul(p, V::pow2(n));
+}
+
+inline reg sigmoid_reg(reg x) {
+    const reg one = V::set1(1.0f);
+    return V::div(one, V::add(one, exp_reg(V::sub(V::zero(), x))));
+}
+
+// tanh(x) = 1 - 2 / (exp(2x) + 1)
+inline reg tanh_reg(reg x) {
+    const reg one = V::set1(1.0f);
+    reg e = exp_reg(V::add(x, x));
+    return V::sub(one, V::div(V::set1(2.0f), V::add(e, one)));
+}
+
+CNN_SIMD_KERNEL inline void exp(const float *in, float *out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(out + i, exp_reg(V::load(in + i)));
+    }
+    if (i < n) scalar::exp(in + i, out + i, n - i);
+}
+
+CNN_SIMD_KERNEL inline void relu(const float *in, float *out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(out + i, V::max(V::load(in + i), V::zero()));
+    }
+    if (i < n) scalar::relu(in + i, out + i, n - i);
+}
+
+CNN_SIMD_KERNEL inline void relu_grad(const float *z, float *g, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(g + i, V::mask_positive(V::load(z + i), V::load(g + i)));
+    }
+    if (i < n) scalar::relu_grad(z + i, g + i, n - i);
+}
+
+CNN_SIMD_KERNEL inline void sigmoid(const float *in, float *out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(out + i, sigmoid_reg(V::load(in + i)));
+    }
+    if (i < n) scalar::sigmoid(in + i, out + i, n - i);
+}
+
+// g *= s * (1 - s)
+CNN_SIMD_KERNEL inline void sigmoid_grad(const float *z, float *g, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        reg s = sigmoid_reg(V::load(z + i));
+        V::store(g + i, V::mul(V::load(g + i), V::mul(s, V::sub(V::set1(1.0f), s))));
+    }
+    if (i < n) scalar::sigmoid_grad(z + i, g + i, n - i);
+}
+
+CNN_SIMD_KERNEL inline void tanh(const float *in, float *out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(out + i, tanh_reg(V::load(in + i)));
+    }
+    if (i < n) scalar::tanh(in + i, out + i, n - i);
+}
+
+// g *= 1 - t^2
+CNN_SIMD_KERNEL inline void tanh_grad(const float *z, float *g, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        reg t = tanh_reg(V::load(z + i));
+        V::store(g + i, V::mul(V::load(g + i), V::sub(V::set1(1.0f), V::mul(t, t))));
+    }
+    if (i < n) scalar::tanh_grad(z + i, g + i, n - i);
+}
+
+// Softmax numericamente estable de un vector
+inline void softmax(const float *in, float *out, size_t n) {
+    const float m = max_value(in, n);
+    const reg max_val = V::set1(m);
+    reg acc = V::zero();
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        reg e = exp_reg(V::sub(V::load(in + i), max_val));
+        V::store(out + i, e);
+        acc = V::add(acc, e);
+    }
+    float sum = V::hsum(acc);
+    if (i < n) {
+        for (size_t j = i; j < n; ++j) {
+            out[j] = in[j] - m;
+        }
+        scalar::exp(out + i, out + i, n - i);
+        for (size_t j = i; j < n; ++j) {
+            sum += out[j];
+        }
+    }
+    const float inv = 1.0f / sum;
+    const reg inv_v = V::set1(inv);
+    for (i = 0; i + W <= n; i += W) {
+        V::store(out + i, V::mul(V::load(out + i), inv_v));
+    }
+    for (; i < n; ++i) {
+        out[i] *= inv;
+    }
+}
+
+// v = beta*v + (1-beta)*g^2;  p -= lr * g / (sqrt(v) + eps)
+CNN_SIMD_KERNEL inline void rmsprop_update(float *param, const float *grad, float *v, size_t n,
+                           float lr, float beta, float eps) {
+    const reg b = V::set1(beta), one_minus_b = V::set1(1.0f - beta);
+    const reg lr_v = V::set1(lr), eps_v = V::set1(eps);
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        reg g = V::load(grad + i);
+        reg vv = V::fmadd(b, V::load(v + i), V::mul(one_minus_b, V::mul(g, g)));
+        V::store(v + i, vv);
+        reg step = V::div(V::mul(lr_v, g), V::add(V::sqrt(vv), eps_v));
+        V::store(param + i, V::sub(V::load(param + i), step));
+    }
+    if (i < n) scalar::rmsprop_update(param + i, grad + i, v + i, n - i, lr, beta, eps);
+}
+
+// Adam con correcciones de sesgo precalculadas (c1 = 1/(1-beta1^t), c2 = 1/(1-beta2^t))
+CNN_SIMD_KERNEL inline void adam_update(float *param, const float *grad, float *m, float *v, size_t n,
+                        float lr, float beta1, float beta2, float c1, float c2, float eps, float weight_decay) {
+    const reg b1 = V::set1(beta1), one_minus_b1 = V::set1(1.0f - beta1);
+    const reg b2 = V::set1(beta2), one_minus_b2 = V::set1(1.0f - beta2);
+    const reg c1_v = V::set1(c1), c2_v = V::set1(c2);
+    const reg lr_v = V::set1(lr), eps_v = V::set1(eps), wd = V::set1(2.0f * weight_decay);
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        reg p = V::load(param + i);
+        reg g = V::fmadd(wd, p, V::load(grad + i)); // Weight decay
+        reg mm = V::fmadd(b1, V::load(m + i), V::mul(one_minus_b1, g));
+        reg vv = V::fmadd(b2, V::load(v + i), V::mul(one_minus_b2, V::mul(g, g)));
+        V::store(m + i, mm);
+        V::store(v + i, vv);
+        reg m_hat = V::mul(mm, c1_v);
+        reg v_hat = V::mul(vv, c2_v);
+        V::store(param + i, V::sub(p, V::div(V::mul(lr_v, m_hat), V::add(V::sqrt(v_hat), eps_v))));
+    }
+    if (i < n) scalar::adam_update(param + i, grad + i, m + i, v + i, n - i, lr, beta1, beta2, c1, c2, eps, weight_decay);
+}
+
+// Conversiones fp32 <-> 16 bits. BF16 -> fp32 y FP16 <-> fp32 son exactos o con el
+// mismo redondeo en todas las variantes (los restos de FP16 usan F16C si esta
+// disponible); fp32 -> BF16 es aritmetica entera (el compilador la vectoriza)
+// sobre la version escalar
+inline void to_bf16(const float *in, uint16_t *out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = bf16_from_float(in[i]);
+    }
+}
+
+inline void from_bf16(const uint16_t *in, float *out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(out + i, V::load_bf16(in + i));
+    }
+    for (; i < n; ++i) {
+        out[i] = float_from_bf16(in[i]);
+    }
+}
+
+inline void to_fp16(const float *in, uint16_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store_fp16(out + i, V::load(in + i));
+    }
+    for (; i < n; ++i) {
+        out[i] = V::float_to_fp16(in[i]);
+    }
+}
+
+inline void from_fp16(const uint16_t *in, float *out, size_t n) {
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(out + i, V::load_fp16(in + i));
+    }
+    for (; i < n; ++i) {
+        out[i] = V::fp16_to_float(in[i]);
+    }
+}
+
+// y += alpha * x con x en 16 bits: la mitad de bytes leidos que axpy
+inline void axpy_bf16(float alpha, const uint16_t *x, float *y, size_t n) {
+    const reg a = V::set1(alpha);
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(y + i, V::fmadd(a, V::load_bf16(x + i), V::load(y + i)));
+    }
+    for (; i < n; ++i) {
+        y[i] += alpha * float_from_bf16(x[i]);
+    }
+}
+
+inline void axpy_fp16(float alpha, const uint16_t *x, float *y, size_t n) {
+    const reg a = V::set1(alpha);
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V::store(y + i, V::fmadd(a, V::load_fp16(x + i), V::load(y + i)));
+    }
+    for (; i < n; ++i) {
+        y[i] += alpha * V::fp16_to_float(x[i]);
+    }
+}
+
+inline Kernels table() {
+    return Kernels{V::name, dot, axpy, mul, max_value,
+                   relu, relu_grad, sigmoid, sigmoid_grad, tanh, tanh_grad, exp, softmax,
+                   rmsprop_update, adam_update, gemv_u8s8, gemm_s8u8, int8_name,
+                   to_bf16, from_bf16, to_fp16, from_fp16, axpy_bf16, axpy_fp16};
+}
@@ -1,37 +1,210 @@
 #pragma once
 
+#include "Shape.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <iostream>
 #include <cassert>
 #include <stdexcept>
+#include <type_traits>
 
 using namespace std;
 
+// Tipo de los elementos de un buffer o de un tensor (se guarda en el archivo del modelo)
+enum class DType : uint32_t {
+    FLOAT32 = 0,
+    INT8 = 1,
+    BF16 = 2, // 8 bits de exponente (rango de fp32), 7 de mantisa
+    FP16 = 3  // IEEE half: 5 bits de exponente, 10 de mantisa
+};
+
+inline bool is_half(DType dtype) { return dtype == DType::BF16 || dtype == DType::FP16; }
+
+inline size_t dtype_size(DType dtype) {
+    return dtype == DType::INT8 ? 1 : is_half(dtype) ? 2 : 4;
+}
+
+inline const char *dtype_name(DType dtype) {
+    switch (dtype) {
+    case DType::INT8: return "int8";
+    case DType::BF16: return "bf16";
+    case DType::FP16: return "fp16";
+    default: return "fp32";
+    }
+}
+
+inline DType parse_dtype(const string &name) {
+    if (name == "fp32") return DType::FLOAT32;
+    if (name == "bf16") return DType::BF16;
+    if (name == "fp16") return DType::FP16;
+    if (name == "int8") return DType::INT8;
+    throw invalid_argument("Tipo de datos desconocido: '" + name + "' (fp32, bf16, fp16 o int8)");
+}
+
+// fp32 <-> 16 bits con los kernels SIMD (redondeo al par mas cercano)
+inline void narrow(const float *in, uint16_t *out, size_t n, DType dtype) {
+    (dtype == DType::BF16 ? simd::kernels().to_bf16 : simd::kernels().to_fp16)(in, out, n);
+}
+
+inline void widen(const uint16_t *in, float *out, size_t n, DType dtype) {
+    (dtype == DType::BF16 ? simd::kernels().from_bf16 : simd::kernels().from_fp16)(in, out, n);
+}
+
+// Datos de solo lectura en fp32 o en 16 bits (p. ej. los pesos de una capa). Los
+// kernels que la reciben convierten cada valor al leerlo y acumulan en fp32
+struct WeightsView {
+    const void *data = nullptr;
+    DType dtype = DType::FLOAT32;
+
+    const float *f32() const { return static_cast<const float *>(data); }
+    const uint16_t *f16() const { return static_cast<const uint16_t *>(data); }
+
+    // Vista desde el elemento 'elements'
+    WeightsView offset(size_t elements) const {
+        return {static_cast<const char *>(data) + elements * (is_half(dtype) ? 2 : 4), dtype};
+    }
+
+    float operator[](size_t i) const {
+        switch (dtype) {
+        case DType::BF16: return simd::float_from_bf16(f16()[i]);
+        case DType::FP16: return simd::float_from_fp16(f16()[i]);
+        default: return f32()[i];
+        }
+    }
+};
+
 class Tensor {
 public:
-    vector<size_t> shape;   // Dimensiones del tensor (ej: [2,3] = matriz 2x3)
-    vector<size_t> strides; // Pasos para navegar entre elementos en memoria
+    Shape shape;            // Dimensiones del tensor (ej: [2,3] = matriz 2x3), en linea
+    Shape strides;          // Pasos para navegar entre elementos en memoria
     vector<float> data;     // Datos almacenados en un array lineal
 
+    // Tipo de almacenamiento. En BF16 / FP16 los valores estan en 'half' y 'data' es
+    // opcional: la copia maestra fp32 que actualiza el optimizador al entrenar
+    // (vacia en inferencia). El acceso por elemento solo vale para 'data'
+    DType dtype = DType::FLOAT32;
+    simd::aligned_vector<uint16_t> half;
+
     // Constructor vacio
     Tensor() {}
 
     // Constructor con forma especifica
-    Tensor(const vector<size_t> &shape_) : shape(shape_) {
-        size_t total_size = 1;
-        for (auto dim : shape)
-            total_size *= dim;
-        data.resize(total_size);
+    Tensor(const Shape &shape_) : shape(shape_) {
+        data.resize(shape.numel());
         compute_strides();
     }
 
-    // Acceso a elementos mediante indices (version modificable)
-    float &operator()(const vector<size_t> &indices) {
+    // Solo la forma, sin reservar los datos (el contenido vive fuera del tensor,
+    // p. ej. en un modelo proyectado con mmap)
+    static Tensor unallocated(const Shape &shape_) {
+        Tensor tensor;
+        tensor.shape = shape_;
+        tensor.compute_strides();
+        return tensor;
+    }
+
+    // Libera los datos conservando la forma
+    void release() {
+        vector<float>().swap(data);
+        simd::aligned_vector<uint16_t>().swap(half);
+    }
+
+    // Cambia el tipo de almacenamiento (FLOAT32, BF16 o FP16) convirtiendo los valores.
+    // En 16 bits la copia fp32 se descarta salvo con 'keep_master'. Un tensor sin datos
+    // (unallocated) solo cambia el tipo
+    void set_dtype(DType target, bool keep_master = false) {
+        if (target != DType::FLOAT32 && !is_half(target)) {
+            throw invalid_argument(string("Tensor: tipo de almacenamiento no soportado: ") + dtype_name(target));
+        }
+        const bool allocated = !data.empty() || !half.empty();
+        if (allocated && data.empty()) {
+            widen_master(); // Los valores actuales en fp32
+        }
+        dtype = target;
+        if (!allocated) {
+            return;
+        }
+        if (target == DType::FLOAT32) {
+            simd::aligned_vector<uint16_t>().swap(half);
+            return;
+        }
+        half.resize(shape.numel());
+        narrow(data.data(), half.data(), half.size(), dtype);
+        if (!keep_master) {
+            vector<float>().swap(data);
+        }
+    }
+
+    // Tiene copia maestra fp32 ademas de los valores en 16 bits
+    bool has_master() const { return is_half(dtype) && !data.empty(); }
+
+    // Crea la copia maestra a partir de los valores en 16 bits
+    void widen_master() {
+        data.resize(shape.numel());
+        widen(half.data(), data.data(), data.size(), dtype);
+    }
+
+    // Redondea el tramo [begin, begin + count) de la copia maestra a los valores en 16 bits
+    void narrow_master(size_t begin, size_t count) {
+        narrow(data.data() + begin, half.data() + begin, count, dtype);
+    }
+
+    // Valores en su tipo de almacenamiento
+    WeightsView storage() const {
+        return {is_half(dtype) ? static_cast<const void *>(half.data()) : data.data(), dtype};
+    }
+
+    // Copia valores de tipo 'src_dtype' (fp32 o 16 bits) convirtiendolos al tipo del
+    // tensor; con copia maestra se actualizan ambos. Para cargar modelos
+    void assign(const void *src, DType src_dtype) {
+        const size_t n = shape.numel();
+        if (!is_half(dtype)) { // fp32 <- fp32 / 16 bits
+            data.resize(n);
+            if (is_half(src_dtype)) {
+                widen(static_cast<const uint16_t *>(src), data.data(), n, src_dtype);
+            } else {
+                std::copy_n(static_cast<const float *>(src), n, data.begin());
+            }
+            return;
+        }
+        half.resize(n);
+        if (src_dtype == dtype) { // Mismo formato de 16 bits: copia directa
+            std::copy_n(static_cast<const uint16_t *>(src), n, half.begin());
+            if (!data.empty()) widen_master();
+            return;
+        }
+        vector<float> values; // fp32 <- 16 bits de otro formato
+        const float *wide = static_cast<const float *>(src);
+        if (is_half(src_dtype)) {
+            values.resize(n);
+            widen(static_cast<const uint16_t *>(src), values.data(), n, src_dtype);
+            wide = values.data();
+        }
+        if (!data.empty()) std::copy_n(wide, n, data.begin());
+        narrow(wide, half.data(), n, dtype);
+    }
+
+    // Acceso a elementos: t(i, j, k, l) sin construir vectores de indices.
+    // Rango e indices solo se verifican en modo debug (sin NDEBUG)
+    template <typename... Idx, typename = enable_if_t<(is_integral<Idx>::value && ...)>>
+    float &operator()(Idx... idx) {
+        return data[offset_of(idx...)];
+    }
+
+    template <typename... Idx, typename = enable_if_t<(is_integral<Idx>::value && ...)>>
+    const float &operator()(Idx... idx) const {
+        return data[offset_of(idx...)];
+    }
+
+    // Acceso con una lista de indices: t({i, j})
+    float &operator()(const Shape &indices) {
         return data[compute_offset(indices)];
     }
 
-    // Acceso a elementos mediante indices (version constante)
-    const float &operator()(const vector<size_t> &indices) const {
+    const float &operator()(const Shape &indices) const {
         return data[compute_offset(indices)];
     }
 
@@ -69,12 +242,36 @@ public:
 
 private:
     // Calcula la posicion en el array lineal dado un conjunto de indices
-    size_t compute_offset(const vector<size_t> &indices) const {
-        assert(indices.size() == shape.size());
+    size_t compute_offset(const Shape &indices) const {
+#ifndef NDEBUG
+        if (indices.size() != shape.size())
+            throw invalid_argument("Numero de indices distinto al rango del tensor");
+#endif
+        size_t offset = 0;
+        for (size_t i = 0; i < indices.size(); ++i) {
+#ifndef NDEBUG
+            if (indices[i] >= shape[i])
+                throw out_of_range("Index out of bounds");
+#endif
+            offset += strides[i] * indices[i];
+        }
+        return offset;
+    }
+
+    // Version variadica: el compilador desenrolla la suma de indices * pasos
+    template <typename... Idx>
+    size_t offset_of(Idx... idx) const {
+        const size_t indices[] = {static_cast<size_t>(idx)...};
+#ifndef NDEBUG
+        if (sizeof...(Idx) != shape.size())
+            throw invalid_argument("Numero de indices distinto al rango del tensor");
+#endif
         size_t offset = 0;
-        for (size_t i = 0; i < shape.size(); ++i) {
+        for (size_t i = 0; i < sizeof...(Idx); ++i) {
+#ifndef NDEBUG
             if (indices[i] >= shape[i])
                 throw out_of_range("Index out of bounds");
+#endif
             offset += strides[i] * indices[i];
         }
         return offset;
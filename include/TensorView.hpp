@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Shape.hpp"
+#include "Tensor.hpp"
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+using namespace std;
+
+// Vista sin propiedad sobre los datos de un Tensor (puntero + forma + pasos).
+// reshape, slice sobre el eje del batch y transpose son O(1): solo cambian la
+// forma y los pasos, nunca copian. La vista es valida mientras viva el buffer.
+//   TensorView      -> datos modificables
+//   ConstTensorView -> solo lectura (se construye implicitamente desde un Tensor)
+template <typename T>
+class BasicTensorView {
+public:
+    T *data = nullptr; // Primer elemento de la vista
+    Shape shape;       // Dimensiones de la vista
+    Shape strides;     // Pasos en elementos (no necesariamente contiguos tras transpose)
+
+    BasicTensorView() {}
+
+    // Vista contigua sobre un buffer externo
+    BasicTensorView(T *data_, const Shape &shape_) : data(data_), shape(shape_) {
+        compute_strides();
+    }
+
+    BasicTensorView(T *data_, const Shape &shape_, const Shape &strides_)
+        : data(data_), shape(shape_), strides(strides_) {}
+
+    // Vista sobre todo un Tensor
+    BasicTensorView(Tensor &tensor) : BasicTensorView(tensor.data.data(), tensor.shape, tensor.strides) {}
+
+    template <typename U = T, typename = enable_if_t<is_const<U>::value>>
+    BasicTensorView(const Tensor &tensor) : BasicTensorView(tensor.data.data(), tensor.shape, tensor.strides) {}
+
+    // TensorView -> ConstTensorView
+    template <typename U, typename = enable_if_t<is_const<T>::value && is_same<const U, T>::value &&
+                                                 !is_same<U, T>::value>>
+    BasicTensorView(const BasicTensorView<U> &other) : data(other.data), shape(other.shape), strides(other.strides) {}
+
+    // Numero total de elementos
+    size_t get_size() const { return shape.numel(); }
+
+    // Los elementos ocupan un bloque contiguo en orden de filas
+    bool is_contiguous() const {
+        size_t expected = 1;
+        for (size_t i = shape.size(); i-- > 0;) {
+            if (shape[i] != 1 && strides[i] != expected) return false;
+            expected *= shape[i];
+        }
+        return true;
+    }
+
+    // Acceso a elementos respetando los pasos: v(i, j, k, l)
+    template <typename... Idx, typename = enable_if_t<(is_integral<Idx>::value && ...)>>
+    T &operator()(Idx... idx) const {
+        const size_t indices[] = {static_cast<size_t>(idx)...};
+#ifndef NDEBUG
+        if (sizeof...(Idx) != shape.size())
+            throw invalid_argument("Numero de indices distinto al rango de la vista");
+#endif
+        size_t offset = 0;
+        for (size_t i = 0; i < sizeof...(Idx); ++i) {
+#ifndef NDEBUG
+            if (indices[i] >= shape[i])
+                throw out_of_range("Index out of bounds");
+#endif
+            offset += strides[i] * indices[i];
+        }
+        return data[offset];
+    }
+
+    // Misma memoria con otra forma (requiere una vista contigua y el mismo numero de elementos)
+    BasicTensorView reshape(const Shape &new_shape) const {
+        if (new_shape.numel() != get_size()) {
+            throw invalid_argument("reshape: el numero de elementos no coincide");
+        }
+        if (!is_contiguous()) {
+            throw invalid_argument("reshape: la vista no es contigua");
+        }
+        return BasicTensorView(data, new_shape);
+    }
+
+    // Aplana cada muestra: [N, d1, d2, ...] -> [N, d1*d2*...]; un vector queda igual
+    BasicTensorView flatten() const {
+        if (shape.size() < 2) {
+            return *this;
+        }
+        return reshape({shape[0], get_size() / shape[0]});
+    }
+
+    // Muestras [begin, end) del eje del batch (eje 0)
+    BasicTensorView slice(size_t begin, size_t end) const {
+        if (shape.empty() || begin > end || end > shape[0]) {
+            throw out_of_range("slice: rango fuera del eje del batch");
+        }
+        BasicTensorView result(data + begin * strides[0], shape, strides);
+        result.shape[0] = end - begin;
+        return result;
+    }
+
+    // Intercambia dos ejes (solo cambian la forma y los pasos)
+    BasicTensorView transpose(size_t a, size_t b) const {
+        if (a >= shape.size() || b >= shape.size()) {
+            throw out_of_range("transpose: eje fuera de rango");
+        }
+        BasicTensorView result(*this);
+        std::swap(result.shape[a], result.shape[b]);
+        std::swap(result.strides[a], result.strides[b]);
+        return result;
+    }
+
+    // Copia a un Tensor propio y contiguo
+    Tensor clone() const {
+        if (data == nullptr) {
+            return Tensor();
+        }
+        Tensor result(shape);
+        if (is_contiguous()) {
+            std::copy(data, data + get_size(), result.data.begin());
+        } else if (get_size() > 0) {
+            copy_strided(result.data.data());
+        }
+        return result;
+    }
+
+private:
+    void compute_strides() {
+        strides.resize(shape.size());
+        size_t stride = 1;
+        for (size_t i = shape.size(); i-- > 0;) {
+            strides[i] = stride;
+            stride *= shape[i];
+        }
+    }
+
+    // Recorre la vista en orden de filas escribiendo de forma contigua
+    void copy_strided(float *dst) const {
+        const size_t rank = shape.size();
+        const size_t inner = shape[rank - 1];
+        const size_t inner_stride = strides[rank - 1];
+        Shape index;
+        index.resize(rank, 0);
+        for (size_t row = 0, rows = get_size() / inner; row < rows; ++row) {
+            size_t offset = 0;
+            for (size_t d = 0; d + 1 < rank; ++d) {
+                offset += index[d] * strides[d];
+            }
+            for (size_t i = 0; i < inner; ++i) {
+                *dst++ = data[offset + i * inner_stride];
+            }
+            // Avanzar el indice de las dimensiones externas
+            for (size_t d = rank - 1; d-- > 0;) {
+                if (++index[d] < shape[d]) break;
+                index[d] = 0;
+            }
+        }
+    }
+};
+
+using TensorView = BasicTensorView<float>;
+using ConstTensorView = BasicTensorView<const float>;
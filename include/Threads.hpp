@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Consultas de OpenMP que tambien compilan sin -fopenmp: en ese caso todo corre en un
+// solo hilo (los '#pragma omp' se ignoran y estas funciones devuelven 1, 0 y false)
+
+// Hilos disponibles para la siguiente region paralela
+inline int thread_count() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// Indice del hilo actual dentro de su region paralela
+inline int thread_index() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// Dentro de una region paralela activa (p. ej. una parte del entrenamiento data-parallel)
+inline bool in_parallel_region() {
+#ifdef _OPENMP
+    return omp_in_parallel() != 0;
+#else
+    return false;
+#endif
+}
+
+// Hilos con buffers propios para un batch: uno por muestra si el batch alcanza para todos
+// los hilos; si no (o ya dentro de una region paralela), uno solo
+inline int batch_threads(size_t batch_size) {
+    if (in_parallel_region()) {
+        return 1;
+    }
+    const int threads = thread_count();
+    return batch_size >= static_cast<size_t>(threads) ? threads : 1;
+}
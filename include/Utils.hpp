@@ -1,7 +1,9 @@
 #pragma once
 
+#include "Activation.hpp"
 #include "Dense.hpp"
 #include "Conv2D.hpp"
+#include "Dropout.hpp"
 #include "Flatten.hpp"
 #include "Pool2D.hpp"
 
@@ -49,14 +51,20 @@ auto dense = [](int in, int out, const string &act, float lambda = 0.0)
     return std::make_unique<Dense>(in, out, act, lambda);
 };
 
+// Capa de activacion por nombre: "relu", "sigmoid", "tanh" o "softmax"
+auto activation_layer = [](const string &name)
+{
+    return make_activation_layer(parse_activation(name));
+};
+
 auto dropout = [](float rate)
 {
     return std::make_unique<Dropout>(rate);
 };
 
-auto conv2d = [](int in_ch, int out_ch, int kernel = 3, int stride = 1, int pad = 0)
+auto conv2d = [](int in_ch, int out_ch, int kernel = 3, int stride = 1, int pad = 0, const string &act = "")
 {
-    return std::make_unique<Conv2D>(in_ch, out_ch, kernel, stride, pad);
+    return std::make_unique<Conv2D>(in_ch, out_ch, kernel, stride, pad, act);
 };
 
 auto flatten = []()
@@ -69,14 +77,14 @@ auto pool = [](size_t pool_size = 2, size_t stride = 2, PoolingType type = Pooli
     return std::make_unique<Pooling2D>(pool_size, stride, type);
 };
 
-// Convertir labels one-hot a tensores 1D [10] (solo para etiquetas)
+// Convertir vectores a tensores 1D (etiquetas one-hot [10] o imagenes aplanadas [784])
 vector<Tensor> to_tensor_batch_1D(const vector<vector<float>> &data)
 {
     vector<Tensor> tensors;
     for (const auto &vec : data)
     {
-        assert(vec.size() == 10 && "Cada etiqueta debe tener 10 valores (one-hot)");
-        Tensor t({vec.size()}); // Tensor 1D [10]
+        assert(!vec.empty() && "Cada muestra debe tener al menos un valor");
+        Tensor t({vec.size()}); // Tensor 1D
         t.data = vec;
         tensors.push_back(t);
     }
@@ -95,4 +103,37 @@ vector<Tensor> to_tensor_batch_4D(const vector<vector<float>> &data)
         tensors.push_back(t);
     }
     return tensors;
-}
\ No newline at end of file
+}
+
+// Agrupa las muestras X[start, end) en un solo tensor de batch
+// - Muestras 4D [1, C, H, W] se concatenan en el eje 0 -> [N, C, H, W]
+// - Cualquier otra forma [...] se apila con un eje nuevo -> [N, ...]
+Tensor stack_batch(const vector<Tensor> &samples, size_t start, size_t end)
+{
+    assert(start < end && end <= samples.size());
+    const Tensor &first = samples[start];
+    size_t n = end - start;
+    size_t sample_size = first.get_size();
+
+    Shape shape;
+    if (first.shape.size() == 4 && first.shape[0] == 1)
+    {
+        shape = first.shape;
+        shape[0] = n;
+    }
+    else
+    {
+        shape.push_back(n);
+        for (size_t dim : first.shape)
+            shape.push_back(dim);
+    }
+
+    Tensor batch(shape);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const auto &src = samples[start + i].data;
+        assert(src.size() == sample_size && "Todas las muestras del batch deben tener la misma forma");
+        std::copy(src.begin(), src.end(), batch.data.begin() + i * sample_size);
+    }
+    return batch;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "MemoryPlan.hpp"
+#include "Shape.hpp"
+#include "Simd.hpp"
+#include "TensorView.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+// Arena de memoria de trabajo de una red: activaciones, gradientes y buffers
+// temporales de un paso se reparten de un solo bloque alineado.
+// - el inicio del bloque se reserva para los planes de memoria (MemoryPlan): los
+//   buffers planificados tienen un offset fijo y comparten memoria segun su vida
+// - el resto se reparte en orden (bump) y reset() lo libera todo de una vez
+// - si el bloque no alcanza (primer paso, batch mas grande), las peticiones se sirven
+//   con bloques extra y en el siguiente reset() el bloque crece al maximo observado
+// En regimen estable un paso no hace ninguna reserva de memoria.
+// No es segura entre hilos: se reserva fuera de las regiones paralelas.
+class Workspace {
+private:
+    simd::aligned_vector<float> block;
+    size_t planned = 0;                           // Floats reservados al inicio para los planes
+    const MemoryPlan *plan = nullptr;             // Plan activo en el paso actual
+    size_t offset = 0;                            // Floats repartidos en orden en el paso actual
+    size_t peak = 0;                              // Maximo de 'offset' en un paso
+    vector<simd::aligned_vector<float>> overflow; // Reservas extra hasta el siguiente reset()
+    size_t heap_allocations = 0;                  // Reservas hechas desde la creacion
+
+    void grow() {
+        block = simd::aligned_vector<float>(planned + peak);
+        ++heap_allocations;
+    }
+
+public:
+    // Buffer de 'count' floats alineado a simd::ALIGNMENT (contenido sin inicializar)
+    float *allocate(size_t count) {
+        const size_t padded = simd::align_floats(std::max<size_t>(count, 1));
+        offset += padded;
+        peak = std::max(peak, offset);
+
+        if (planned + offset <= block.size()) {
+            return block.data() + planned + (offset - padded);
+        }
+        overflow.emplace_back(padded);
+        ++heap_allocations;
+        return overflow.back().data();
+    }
+
+    // Buffer identificado (owner, slot): usa su region del plan activo si cabe en ella
+    float *allocate(const void *owner, int slot, size_t count) {
+        if (plan) {
+            const MemoryPlan::Region *region = plan->find({owner, slot});
+            if (region && count <= region->size) {
+                return block.data() + region->offset;
+            }
+        }
+        return allocate(count);
+    }
+
+    // Vistas contiguas con la forma pedida (contenido sin inicializar)
+    TensorView tensor(const Shape &shape) { return TensorView(allocate(shape.numel()), shape); }
+
+    TensorView tensor(const void *owner, int slot, const Shape &shape) {
+        return TensorView(allocate(owner, slot, shape.numel()), shape);
+    }
+
+    // Reserva 'floats' al inicio del bloque para los planes de memoria.
+    // Invalida todas las vistas entregadas (solo se llama al planificar)
+    void reserve_planned(size_t floats) {
+        planned = floats;
+        plan = nullptr;
+        overflow.clear();
+        offset = 0;
+        if (block.size() < planned + peak) {
+            grow();
+        }
+    }
+
+    // Comienza un paso nuevo con el plan indicado (debe caber en lo reservado):
+    // todas las vistas entregadas dejan de ser validas
+    void reset(const MemoryPlan *active_plan = nullptr) {
+        if (!overflow.empty()) {
+            overflow.clear();
+            grow();
+        }
+        offset = 0;
+        plan = (active_plan && active_plan->size <= planned) ? active_plan : nullptr;
+    }
+
+    size_t capacity() const { return block.size(); } // Floats del bloque principal
+    size_t planned_size() const { return planned; }  // Floats reservados para los planes
+    size_t used() const { return offset; }           // Floats repartidos en orden en el paso actual
+    size_t allocations() const { return heap_allocations; }
+};
@@ -0,0 +1,157 @@
+#include "Conv2D.hpp"
+#include "Dataset.hpp"
+#include "Flatten.hpp"
+#include "Math.hpp"
+#include "NeuralNetwork.hpp"
+#include "Pool2D.hpp"
+#include "Utils.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Cuantizacion int8 post-entrenamiento del modelo de cnn.cpp: calibra con muestras del
+// conjunto de entrenamiento y compara con fp32 sobre el test de MNIST (precision como en
+// test_model, predicciones que coinciden, tamaño de los pesos e imagenes por segundo).
+// Tambien mide los pesos en bf16 y fp16 (set_precision) y comprueba que un modelo del
+// formato anterior cargado sobre capas bf16 predice lo mismo.
+// Guarda el modelo cuantizado en models/cnn_mnist_int8.bin
+
+const string TRAIN_PATH = "./database/mnist_train.bin";
+const string TEST_PATH = "./database/mnist_test.bin";
+const string MODEL_PATH = "models/cnn_mnist.bin";
+const string LEGACY_PATH = "models/cnn_mnist_legacy.bin";
+const size_t CALIBRATION_SAMPLES = 1000;
+const int REPEATS = 5;
+
+struct Report {
+  float accuracy;
+  double images_per_second;
+  size_t weight_bytes;
+  Tensor pred;
+};
+
+Report evaluate(NeuralNetwork &model, const Tensor &images, const Tensor &labels) {
+  Report report;
+  report.pred = model.predict(images); // Calentamiento (arenas y caches)
+  double best = 0.0;
+  for (int r = 0; r < REPEATS; ++r) {
+    auto start = start_timer();
+    model.predict(images);
+    double elapsed = stop_timer(start);
+    best = (r == 0) ? elapsed : min(best, elapsed);
+  }
+  report.accuracy = 100.0f * model.accuracy(report.pred, labels) / images.shape[0];
+  report.images_per_second = images.shape[0] / best;
+  report.weight_bytes = model.weight_bytes();
+  return report;
+}
+
+size_t agreement(const Tensor &a, const Tensor &b) {
+  size_t agree = 0;
+  const size_t classes = a.shape[1];
+  for (size_t i = 0; i < a.shape[0]; ++i) {
+    agree += argmax(a.data.data() + i * classes, classes) == argmax(b.data.data() + i * classes, classes);
+  }
+  return agree;
+}
+
+// Arquitectura de cnn.cpp. Con 'weights' devuelve los tensores en el orden del formato
+// anterior (kernels y bias de Conv2D, pesos y bias de Dense)
+void build(NeuralNetwork &model, vector<const Tensor *> *weights = nullptr) {
+  auto conv = conv2d(1, 8, 5, 2, 2);
+  auto hidden = dense(392, 32, "relu");
+  auto output = dense(32, 10, "softmax");
+  if (weights) {
+    *weights = {&conv->kernels, &conv->bias, &hidden->weights, &hidden->bias, &output->weights, &output->bias};
+  }
+  model.add_layer(std::move(conv));
+  model.add_layer(pool(2, 2, PoolingType::MAX));
+  model.add_layer(flatten());
+  model.add_layer(std::move(hidden));
+  model.add_layer(std::move(output));
+}
+
+void load(NeuralNetwork &model) {
+  if (model_file::is_model_file(MODEL_PATH)) {
+    model.load_model(MODEL_PATH); // Arquitectura desde el archivo
+  } else {
+    build(model);
+    model.load_model(MODEL_PATH);
+  }
+}
+
+// Guarda los pesos fp32 en el formato anterior (solo floats) y los carga sobre una red
+// ya convertida a bf16: las predicciones deben coincidir con 'bf16_pred'
+size_t legacy_bf16_agreement(const Tensor &images, const Tensor &bf16_pred) {
+  NeuralNetwork fp32_model;
+  vector<const Tensor *> weights;
+  build(fp32_model, &weights);
+  fp32_model.load_model(MODEL_PATH);
+  {
+    ofstream file(LEGACY_PATH, ios::binary);
+    for (const Tensor *tensor : weights) {
+      file.write(reinterpret_cast<const char *>(tensor->data.data()), tensor->data.size() * sizeof(float));
+    }
+  }
+
+  NeuralNetwork legacy_model;
+  build(legacy_model);
+  legacy_model.set_precision(DType::BF16);
+  legacy_model.load_model(LEGACY_PATH);
+  filesystem::remove(LEGACY_PATH);
+  return agreement(bf16_pred, legacy_model.predict(images));
+}
+
+int main() {
+  NeuralNetwork model;
+  load(model);
+
+  MnistDataset train(TRAIN_PATH, SampleLayout::IMAGE);
+  MnistDataset test(TEST_PATH, SampleLayout::IMAGE);
+  Tensor images, labels;
+  test.get_batch(0, test.size(), images, labels);
+
+  cout << "kernels: " << simd::kernels().name << ", int8: " << simd::kernels().int8_name << endl;
+  Report fp32 = evaluate(model, images, labels);
+
+  // Pesos en 16 bits (cada uno desde los fp32 originales)
+  NeuralNetwork bf16_model, fp16_model;
+  load(bf16_model);
+  load(fp16_model);
+  bf16_model.set_precision(DType::BF16);
+  fp16_model.set_precision(DType::FP16);
+  Report bf16 = evaluate(bf16_model, images, labels);
+  Report fp16 = evaluate(fp16_model, images, labels);
+  const size_t legacy_agree = legacy_bf16_agreement(images, bf16.pred);
+
+  auto start = start_timer();
+  model.quantize(train, CALIBRATION_SAMPLES);
+  double calibration = stop_timer(start);
+  Report int8 = evaluate(model, images, labels);
+
+  const size_t agree = agreement(fp32.pred, int8.pred);
+
+  cout << "Calibracion: " << min(CALIBRATION_SAMPLES, train.size()) << " muestras en " << fixed << setprecision(1)
+       << calibration * 1e3 << " ms" << endl;
+  cout << "\n        | precision |     pesos |        img/s | iguales a fp32" << endl;
+  for (const auto &[name, report] : {pair<const char *, const Report &>{"fp32", fp32}, {"bf16", bf16},
+                                     {"fp16", fp16}, {"int8", int8}}) {
+    cout << setw(7) << name << " | " << setw(8) << setprecision(2) << report.accuracy << "% | " << setw(7)
+         << report.weight_bytes / 1024.0 << " KB | " << setw(12) << setprecision(0) << report.images_per_second
+         << " | " << setw(13) << setprecision(2) << 100.0 * agreement(fp32.pred, report.pred) / test.size() << "%"
+         << endl;
+  }
+  cout << "Formato anterior cargado en bf16: " << setprecision(2) << 100.0 * legacy_agree / test.size()
+       << "% iguales a bf16" << endl;
+  cout << "\nPredicciones iguales: " << setprecision(2) << 100.0 * agree / test.size() << "%, pesos "
+       << static_cast<double>(fp32.weight_bytes) / int8.weight_bytes << "x menores, " << int8.images_per_second / fp32.images_per_second
+       << "x img/s" << endl;
+
+  model.save_model("cnn_mnist_int8.bin");
+  return 0;
+}
@@ -1,10 +1,10 @@
 #include "Conv2D.hpp"
+#include "Dataset.hpp"
 #include "Dense.hpp"
 #include "Flatten.hpp"
 #include "Layer.hpp"
 #include "NeuralNetwork.hpp"
 #include "Pool2D.hpp"
-#include "Reader.hpp"
 #include "Tensor.hpp"
 #include "Utils.hpp"
 
@@ -14,20 +14,16 @@
 
 using namespace std;
 
-void test_model(NeuralNetwork &model, vector<Tensor> &X_test, vector<Tensor> &Y_test) {
+void test_model(NeuralNetwork &model, const Dataset &test) {
   cout << "\nIniciando evaluación del modelo en el conjunto de test..." << endl;
+  const size_t batch = 100;
+  Tensor X_batch, Y_batch;
   int correct = 0;
-  const int total = X_test.size();
+  const int total = test.size();
 
-  for (int i = 0; i < total; i++) {
-    Tensor pred = model.predict(X_test[i]);
-
-    int pred_label = argmax(pred);
-    int true_label = argmax(Y_test[i]);
-
-    if (pred_label == true_label) {
-      correct++;
-    }
+  for (size_t start = 0; start < test.size(); start += batch) {
+    test.get_batch(start, min(start + batch, test.size()), X_batch, Y_batch);
+    correct += static_cast<int>(model.accuracy(model.predict(X_batch), Y_batch));
   }
 
   // Calcula y muestra la precisión final
@@ -67,15 +63,11 @@ int main() {
 
   // Cargar los datos de test de MNIST
   cout << "3. Cargando datos de test de MNIST..." << endl;
-  vector<vector<float>> raw_X_test, raw_Y_test;
-  Reader::load_bin("./database/mnist_test.bin", raw_X_test, raw_Y_test, 10000);
-
-  vector<Tensor> X_test = to_tensor_batch_4D(raw_X_test);
-  vector<Tensor> Y_test = to_tensor_batch_1D(raw_Y_test);
-  cout << "   Datos de test cargados (" << X_test.size() << " muestras)." << endl;
+  MnistDataset test("./database/mnist_test.bin", SampleLayout::IMAGE, 10000);
+  cout << "   Datos de test cargados (" << test.size() << " muestras)." << endl;
 
   // Evaluar el modelo con los datos cargados
-  test_model(model, X_test, Y_test);
+  test_model(model, test);
 
   return 0;
 }
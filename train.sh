@@ -6,6 +6,20 @@ elif [ "$1" == "cnn" ]; then
   g++ -fopenmp -O3 -std=c++17 cnn.cpp -Iinclude -o cnn && ./cnn
 elif [ "$1" == "testcnn" ]; then
   g++ -fopenmp -O3 -std=c++17 test.cpp -Iinclude -o testcnn && ./testcnn
+elif [ "$1" == "benchconv" ]; then
+  g++ -fopenmp -O3 -std=c++17 bench_conv.cpp -Iinclude -o bench_conv && ./bench_conv
+elif [ "$1" == "benchinfer" ]; then
+  g++ -fopenmp -O3 -std=c++17 bench_inference.cpp -Iinclude -o bench_inference && ./bench_inference
+elif [ "$1" == "quantize" ]; then
+  g++ -fopenmp -O3 -std=c++17 quantize.cpp -Iinclude -o quantize && ./quantize
+elif [ "$1" == "distributed" ]; then
+  # ./train.sh distributed [procesos]: lanza los procesos en esta maquina
+  PROCS=${2:-2}
+  g++ -fopenmp -O3 -std=c++17 cnn_distributed.cpp -Iinclude -o cnn_distributed || exit 1
+  for ((r = 0; r < PROCS; r++)); do
+    OMP_NUM_THREADS=${OMP_NUM_THREADS:-1} ./cnn_distributed $r $PROCS &
+  done
+  wait
 elif [ "$1" == "test" ]; then
   g++ test.cpp -o test && ./test
 elif [ "$1" == "plot" ]; then
@@ -13,7 +27,7 @@ elif [ "$1" == "plot" ]; then
   python3 plot.py
   cd ../lab6
 else
-  echo "Uso: $0 [mlp|cnn|test|plot]"
+  echo "Uso: $0 [mlp|cnn|testcnn|benchconv|benchinfer|quantize|distributed [procesos]|test|plot]"
   exit 1
 fi
 